@@ -0,0 +1,76 @@
+#include "arena.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace garda {
+
+struct Arena::Block {
+    Block *next;
+    std::size_t size;
+
+    char *begin() { return reinterpret_cast<char *>(this + 1); }
+    char *end() { return begin() + size; }
+};
+
+Arena::Arena(std::size_t block_bytes) : block_bytes_(block_bytes ? block_bytes : 1) {}
+
+Arena::~Arena() {
+    for (Block *b = first_; b;) {
+        Block *next = b->next;
+        std::free(b);
+        b = next;
+    }
+}
+
+void Arena::enter(Block *b) {
+    current_ = b;
+    ptr_ = b->begin();
+    end_ = b->end();
+}
+
+void *Arena::allocate_slow(std::size_t n, std::size_t align) {
+    // Reuse the blocks kept from before the last rewind while they fit;
+    // otherwise splice a new block in after the current one.
+    Block *next = current_ ? current_->next : first_;
+    if (!next || next->size < n + align) {
+        std::size_t size = n + align > block_bytes_ ? n + align : block_bytes_;
+        void *mem = std::malloc(sizeof(Block) + size);
+        if (!mem)
+            throw std::bad_alloc();
+        ++system_allocations_;
+        reserved_ += size;
+        Block *b = static_cast<Block *>(mem);
+        b->size = size;
+        b->next = next;
+        if (current_)
+            current_->next = b;
+        else
+            first_ = b;
+        next = b;
+    }
+    enter(next);
+    return allocate(n, align);
+}
+
+void Arena::rewind(const Mark &m) {
+    if (!m.block) {
+        reset();
+        return;
+    }
+    current_ = static_cast<Block *>(m.block);
+    ptr_ = m.ptr;
+    end_ = current_->end();
+}
+
+void Arena::reset() {
+    current_ = nullptr;
+    ptr_ = end_ = nullptr;
+}
+
+Arena &thread_arena() {
+    thread_local Arena arena;
+    return arena;
+}
+
+} // namespace garda
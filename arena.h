@@ -0,0 +1,105 @@
+#ifndef GARDA_ARENA_H
+#define GARDA_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace garda {
+
+// Monotonic bump allocator. allocate() moves a pointer through the current
+// block; memory is never freed one object at a time, only all at once by
+// rewinding to a mark (see ArenaScope) or reset(). Blocks are kept across
+// rewinds, so once an arena has grown to the largest request it serves it
+// stops calling malloc altogether. Not thread-safe: use one per thread,
+// e.g. thread_arena().
+class Arena {
+public:
+    struct Mark {
+        void *block;
+        char *ptr;
+    };
+
+    explicit Arena(std::size_t block_bytes = 64 * 1024);
+    ~Arena();
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    void *allocate(std::size_t n, std::size_t align = alignof(std::max_align_t)) {
+        auto p = (reinterpret_cast<std::uintptr_t>(ptr_) + align - 1) & ~(align - 1);
+        if (p + n <= reinterpret_cast<std::uintptr_t>(end_)) {
+            ptr_ = reinterpret_cast<char *>(p + n);
+            return reinterpret_cast<void *>(p);
+        }
+        return allocate_slow(n, align);
+    }
+
+    Mark mark() const { return {current_, ptr_}; }
+    void rewind(const Mark &m);
+    void reset();
+
+    // Blocks obtained from malloc over the arena's lifetime.
+    std::uint64_t system_allocations() const { return system_allocations_; }
+    std::size_t reserved_bytes() const { return reserved_; }
+
+private:
+    struct Block;
+
+    void *allocate_slow(std::size_t n, std::size_t align);
+    void enter(Block *b);
+
+    std::size_t block_bytes_;
+    Block *first_ = nullptr;
+    Block *current_ = nullptr;
+    char *ptr_ = nullptr;
+    char *end_ = nullptr;
+    std::uint64_t system_allocations_ = 0;
+    std::size_t reserved_ = 0;
+};
+
+// The calling thread's arena, created on first use.
+Arena &thread_arena();
+
+// Rewinds an arena to where it stood when the scope was entered: one bulk
+// free for everything allocated per request or per batch.
+class ArenaScope {
+public:
+    explicit ArenaScope(Arena &arena) : arena_(arena), mark_(arena.mark()) {}
+    ~ArenaScope() { arena_.rewind(mark_); }
+
+    ArenaScope(const ArenaScope &) = delete;
+    ArenaScope &operator=(const ArenaScope &) = delete;
+
+private:
+    Arena &arena_;
+    Arena::Mark mark_;
+};
+
+// Standard allocator over an Arena; deallocate() is a no-op.
+template <typename T>
+struct ArenaAllocator {
+    using value_type = T;
+
+    Arena *arena;
+
+    explicit ArenaAllocator(Arena &a) : arena(&a) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+    T *allocate(std::size_t n) {
+        return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T *, std::size_t) {}
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U> &other) const { return arena != other.arena; }
+};
+
+using ArenaString = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+
+} // namespace garda
+
+#endif // GARDA_ARENA_H
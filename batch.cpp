@@ -0,0 +1,125 @@
+#include "batch.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sys/uio.h>
+
+#include "pattern_fill.h"
+#include "stats.h"
+
+namespace garda {
+
+namespace {
+
+#ifdef IOV_MAX
+constexpr int kMaxIov = IOV_MAX;
+#else
+constexpr int kMaxIov = 1024;
+#endif
+
+// Issues writev() until every iovec in [iov, iov + n) has been written.
+bool writev_all(int fd, struct iovec *iov, int n, BatchStats &stats) {
+    while (n > 0) {
+        ssize_t w = ::writev(fd, iov, n);
+        ++stats.syscalls;
+        if (w < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        stats.bytes += static_cast<std::uint64_t>(w);
+        note_write(static_cast<std::size_t>(w));
+        std::size_t left = static_cast<std::size_t>(w);
+        while (n > 0 && left >= iov->iov_len) {
+            left -= iov->iov_len;
+            ++iov;
+            --n;
+        }
+        if (n > 0) {
+            iov->iov_base = static_cast<char *>(iov->iov_base) + left;
+            iov->iov_len -= left;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool write_repeated(int fd, std::string_view line, std::uint64_t count, BatchStats *stats,
+                    std::size_t block_bytes) {
+    BatchStats local;
+    BatchStats &st = stats ? *stats : local;
+    if (count == 0 || line.empty())
+        return true;
+
+    std::uint64_t per_block = block_bytes / line.size();
+    if (per_block == 0)
+        per_block = 1;
+    if (per_block > count)
+        per_block = count;
+    std::size_t block_len = static_cast<std::size_t>(per_block) * line.size();
+    std::unique_ptr<char[]> block(new char[block_len]);
+    fill_pattern(block.get(), block_len, line);
+    return write_lines_from_block(fd, std::string_view(block.get(), block_len), line.size(),
+                                  count, &st);
+}
+
+bool write_lines_from_block(int fd, std::string_view block, std::size_t line_size,
+                            std::uint64_t count, BatchStats *stats) {
+    BatchStats local;
+    BatchStats &st = stats ? *stats : local;
+    if (count == 0 || line_size == 0 || block.size() < line_size)
+        return true;
+
+    std::uint64_t per_block = block.size() / line_size;
+    if (per_block > count)
+        per_block = count;
+    std::size_t block_len = static_cast<std::size_t>(per_block) * line_size;
+    char *base = const_cast<char *>(block.data());
+
+    std::uint64_t blocks = count / per_block;
+    std::size_t tail = static_cast<std::size_t>(count % per_block) * line_size;
+    std::size_t iov_len = blocks < static_cast<std::uint64_t>(kMaxIov)
+                              ? static_cast<std::size_t>(blocks) + 1
+                              : static_cast<std::size_t>(kMaxIov);
+    std::vector<struct iovec> iov(iov_len);
+    while (blocks > 0 || tail > 0) {
+        int n = 0;
+        for (; n < static_cast<int>(iov_len) && blocks > 0; ++n, --blocks)
+            iov[n] = {base, block_len};
+        if (n < static_cast<int>(iov_len) && blocks == 0 && tail > 0) {
+            iov[n++] = {base, tail};
+            tail = 0;
+        }
+        if (!writev_all(fd, iov.data(), n, st))
+            return false;
+    }
+    return true;
+}
+
+bool write_repeated(Sink &sink, std::string_view line, std::uint64_t count,
+                    std::size_t block_bytes) {
+    if (count == 0 || line.empty())
+        return sink.sync();
+    std::uint64_t per_block = std::max<std::uint64_t>(1, block_bytes / line.size());
+    if (per_block > count)
+        per_block = count;
+    std::string block(static_cast<std::size_t>(per_block) * line.size(), '\0');
+    fill_pattern(&block[0], block.size(), line);
+
+    bool ok = true;
+    for (std::uint64_t left = count; left > 0 && ok;) {
+        std::uint64_t n = left < per_block ? left : per_block;
+        ok = sink.write(block.data(), static_cast<std::size_t>(n) * line.size());
+        left -= n;
+    }
+    return sink.sync() && ok;
+}
+
+} // namespace garda
@@ -0,0 +1,37 @@
+#ifndef GARDA_BATCH_H
+#define GARDA_BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "output.h"
+
+namespace garda {
+
+struct BatchStats {
+    std::uint64_t bytes = 0;
+    std::uint64_t syscalls = 0;
+};
+
+// Writes line to fd count times. The line is replicated into one block of
+// roughly block_bytes and the block is pushed with writev() using up to
+// IOV_MAX iovecs per call, so the cost per line is a fraction of a syscall.
+// Returns false if a write fails; stats (optional) reflect what was written.
+bool write_repeated(int fd, std::string_view line, std::uint64_t count,
+                    BatchStats *stats = nullptr, std::size_t block_bytes = 64 * 1024);
+
+// Writes count lines of line_size bytes to fd out of block, which already
+// holds whole copies of the line (e.g. one rendered ahead of time, see
+// snapshot.h); same strategy and contract as write_repeated().
+bool write_lines_from_block(int fd, std::string_view block, std::size_t line_size,
+                            std::uint64_t count, BatchStats *stats = nullptr);
+
+// Writes line count times through sink in blocks of about block_bytes and
+// syncs it; for sinks that queue writes, such as UringSink.
+bool write_repeated(Sink &sink, std::string_view line, std::uint64_t count,
+                    std::size_t block_bytes = 256 * 1024);
+
+} // namespace garda
+
+#endif // GARDA_BATCH_H
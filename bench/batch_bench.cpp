@@ -0,0 +1,75 @@
+// Pushes N greetings through a pipe with garda::write_repeated() while a
+// second thread drains it, reporting lines/s, GB/s and syscalls.
+// Usage: batch_bench [lines...]   (default: 1000000 100000000)
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "batch.h"
+#include "greeting.h"
+
+namespace {
+
+std::uint64_t drain(int fd) {
+    std::vector<char> buf(1 << 20);
+    std::uint64_t total = 0;
+    for (;;) {
+        ssize_t n = ::read(fd, buf.data(), buf.size());
+        if (n <= 0)
+            return total;
+        total += static_cast<std::uint64_t>(n);
+    }
+}
+
+template <typename Fn>
+void run(const char *name, std::uint64_t lines, Fn &&write_all) {
+    int p[2];
+    if (::pipe(p) != 0) {
+        std::perror("pipe");
+        std::exit(1);
+    }
+    std::uint64_t received = 0;
+    std::thread reader([&] { received = drain(p[0]); });
+    auto start = std::chrono::steady_clock::now();
+    std::uint64_t syscalls = write_all(p[1]);
+    ::close(p[1]);
+    reader.join();
+    std::chrono::duration<double> dt = std::chrono::steady_clock::now() - start;
+    ::close(p[0]);
+    std::printf("%-12s %11llu lines %14.0f lines/s %7.3f GB/s %10llu syscalls\n", name,
+                static_cast<unsigned long long>(lines), lines / dt.count(),
+                received / dt.count() / 1e9, static_cast<unsigned long long>(syscalls));
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::vector<std::uint64_t> sizes;
+    for (int i = 1; i < argc; ++i)
+        sizes.push_back(std::strtoull(argv[i], nullptr, 10));
+    if (sizes.empty())
+        sizes = {1000000, 100000000};
+
+    for (std::uint64_t lines : sizes) {
+        if (lines <= 1000000) {
+            run("write/line", lines, [&](int fd) {
+                for (std::uint64_t i = 0; i < lines; ++i)
+                    if (::write(fd, garda::kGreeting.data(), garda::kGreeting.size()) < 0)
+                        break;
+                return lines;
+            });
+        }
+        run("writev", lines, [&](int fd) {
+            garda::BatchStats stats;
+            garda::write_repeated(fd, garda::kGreeting, lines, &stats);
+            return stats.syscalls;
+        });
+    }
+    return 0;
+}
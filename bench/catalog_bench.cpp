@@ -0,0 +1,58 @@
+// Measures greeting lookup cost across every language in the catalog:
+// the compiled perfect hash against a linear scan and std::unordered_map.
+// Usage: catalog_bench [rounds]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "catalog.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+template <typename Fn>
+void run(const char *name, const std::vector<std::string> &keys, long rounds, Fn &&lookup) {
+    std::size_t sink = 0;
+    auto start = Clock::now();
+    for (long r = 0; r < rounds; ++r)
+        for (const std::string &k : keys)
+            sink += lookup(k);
+    std::chrono::duration<double, std::nano> dt = Clock::now() - start;
+    double lookups = static_cast<double>(rounds) * static_cast<double>(keys.size());
+    std::printf("%-16s %8.2f ns/lookup  (checksum %zu)\n", name, dt.count() / lookups, sink);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    long rounds = argc > 1 ? std::atol(argv[1]) : 200000;
+    std::vector<std::string> langs, locales;
+    std::unordered_map<std::string_view, const garda::CatalogEntry *> map;
+    for (std::size_t i = 0; i < garda::catalog_size(); ++i) {
+        const garda::CatalogEntry &e = garda::catalog_entry(i);
+        langs.emplace_back(e.lang);
+        locales.push_back(std::string(e.lang) + (e.lang.size() == 2 ? "_XX.UTF-8" : ".UTF-8"));
+        map.emplace(e.lang, &e);
+    }
+    std::printf("%zu languages, %ld rounds\n", langs.size(), rounds);
+
+    run("perfect hash", langs, rounds,
+        [](std::string_view k) { return garda::find_greeting(k)->line.size(); });
+    run("locale name", locales, rounds,
+        [](std::string_view k) { return garda::greeting_for_locale(k)->line.size(); });
+    run("linear scan", langs, rounds, [](std::string_view k) {
+        for (std::size_t i = 0; i < garda::catalog_size(); ++i)
+            if (garda::catalog_entry(i).lang == k)
+                return garda::catalog_entry(i).line.size();
+        return std::size_t(0);
+    });
+    run("unordered_map", langs, rounds,
+        [&](std::string_view k) { return map.find(k)->second->line.size(); });
+    return 0;
+}
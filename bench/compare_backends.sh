@@ -0,0 +1,25 @@
+#!/bin/sh
+# Builds Tets_GARDA with each output backend and compares binary size and
+# startup latency. Usage: bench/compare_backends.sh [runs]
+set -e
+src=$(cd "$(dirname "$0")/.." && pwd)
+out=${BUILD_ROOT:-$src/_backend_builds}
+runs=${1:-2000}
+
+for backend in iostream fd; do
+    cmake -S "$src" -B "$out/$backend" -DCMAKE_BUILD_TYPE=Release \
+        -DGARDA_OUTPUT_BACKEND=$backend >/dev/null
+    cmake --build "$out/$backend" --target Tets_GARDA startup_bench >/dev/null
+done
+
+printf '%-10s %10s\n' backend bytes
+printf '%-10s %10s  (committed aarch64 build)\n' hello "$(wc -c <"$src/hello")"
+for backend in iostream fd; do
+    printf '%-10s %10s\n' $backend "$(wc -c <"$out/$backend/Tets_GARDA")"
+done
+
+for backend in iostream fd; do
+    echo
+    echo "== $backend"
+    "$out/iostream/startup_bench" -n "$runs" "$out/$backend/Tets_GARDA"
+done
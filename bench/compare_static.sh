@@ -0,0 +1,67 @@
+#!/bin/sh
+# Builds Tets_GARDA dynamically and with -DGARDA_STATIC=ON and compares
+# binary size, shared-library dependencies and spawn cost (exec-to-exit
+# latency, page faults, peak RSS) with startup_bench.
+# If an aarch64 cross compiler and qemu-aarch64 are installed, the same is
+# repeated for aarch64 under qemu-user; those latencies include qemu's own
+# startup and translation, so only compare them with each other.
+# Usage: bench/compare_static.sh [runs]
+# Environment: BUILD_ROOT, CROSS_CXX (aarch64-linux-gnu-g++),
+#              QEMU_LD_PREFIX (/usr/aarch64-linux-gnu, for the dynamic build)
+set -e
+src=$(cd "$(dirname "$0")/.." && pwd)
+out=${BUILD_ROOT:-$src/_static_builds}
+runs=${1:-2000}
+cross=${CROSS_CXX:-aarch64-linux-gnu-g++}
+sysroot=${QEMU_LD_PREFIX:-/usr/aarch64-linux-gnu}
+
+build() { # dir cmake-args...
+    dir=$1
+    shift
+    cmake -S "$src" -B "$dir" -DCMAKE_BUILD_TYPE=Release -DGARDA_OUTPUT_BACKEND=fd "$@" >/dev/null
+    cmake --build "$dir" --target Tets_GARDA >/dev/null
+}
+
+sizes() { # arch
+    for link in dynamic static; do
+        bin="$out/$1-$link/Tets_GARDA"
+        deps=$(readelf -d "$bin" 2>/dev/null | grep -c NEEDED || true)
+        printf '%-8s %-8s %10s bytes  %s shared libraries\n' "$1" $link "$(wc -c <"$bin")" "$deps"
+    done
+}
+
+build "$out/x86_64-dynamic" -DGARDA_STATIC=OFF
+build "$out/x86_64-static" -DGARDA_STATIC=ON
+cmake --build "$out/x86_64-dynamic" --target startup_bench >/dev/null
+bench="$out/x86_64-dynamic/startup_bench"
+sizes x86_64
+
+aarch64=
+if command -v "$cross" >/dev/null && command -v qemu-aarch64 >/dev/null; then
+    aarch64=1
+    for link in dynamic static; do
+        flag=OFF
+        [ $link = static ] && flag=ON
+        build "$out/aarch64-$link" -DGARDA_STATIC=$flag -DGARDA_BUILD_BENCH=OFF \
+            -DCMAKE_SYSTEM_NAME=Linux -DCMAKE_SYSTEM_PROCESSOR=aarch64 \
+            -DCMAKE_CXX_COMPILER="$cross"
+    done
+    sizes aarch64
+    printf '%-8s %-8s %10s bytes  (committed build)\n' aarch64 hello "$(wc -c <"$src/hello")"
+else
+    echo "aarch64: $cross or qemu-aarch64 not found, skipped"
+fi
+
+for link in dynamic static; do
+    echo
+    echo "== x86_64 $link"
+    "$bench" -n "$runs" "$out/x86_64-$link/Tets_GARDA"
+done
+if [ -n "$aarch64" ]; then
+    qemu=$(command -v qemu-aarch64)
+    for link in dynamic static; do
+        echo
+        echo "== aarch64 $link (qemu-user)"
+        "$bench" -n "$runs" "$qemu" -L "$sysroot" "$out/aarch64-$link/Tets_GARDA"
+    done
+fi
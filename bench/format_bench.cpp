@@ -0,0 +1,163 @@
+// Rendering a --format line: the compiled LineFormat instruction stream
+// against building the same line with std::string concatenation and
+// against substituting the fields into the template text for every line.
+// Counts every operator new; all three append to one reused buffer.
+// Usage: format_bench [lines]
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <string_view>
+
+#include <unistd.h>
+
+#include "greeting.h"
+#include "int_format.h"
+#include "line_format.h"
+
+namespace {
+
+std::atomic<std::uint64_t> heap_allocations{0};
+
+} // namespace
+
+void *operator new(std::size_t n) {
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(n ? n : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::string_view kFormat = "{greeting} from {host}[{pid}] #{n} {time}";
+constexpr std::uint64_t kBatch = 4096;
+
+// Replaces every "{name}" in text, looked up by name, the way a
+// straightforward runtime template would.
+template <typename Lookup>
+void substitute(std::string_view text, std::string &out, Lookup &&lookup) {
+    std::string line;
+    for (std::size_t i = 0; i < text.size();) {
+        std::size_t open = text.find('{', i);
+        if (open == std::string_view::npos) {
+            line += text.substr(i);
+            break;
+        }
+        std::size_t close = text.find('}', open);
+        line += text.substr(i, open - i);
+        line += lookup(text.substr(open + 1, close - open - 1));
+        i = close + 1;
+    }
+    line += '\n';
+    out += line;
+}
+
+void report(const char *name, std::uint64_t lines, std::uint64_t allocations, double seconds,
+            std::size_t bytes) {
+    std::printf("%-14s %8.3f allocations/line  %7.2f M lines/s  %6.1f ns/line  (%zu bytes)\n",
+                name, static_cast<double>(allocations) / static_cast<double>(lines),
+                static_cast<double>(lines) / seconds / 1e6,
+                seconds * 1e9 / static_cast<double>(lines), bytes);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::uint64_t lines = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+    lines += kBatch - 1;
+    lines -= lines % kBatch;
+
+    std::string greeting(garda::kGreeting.substr(0, garda::kGreeting.size() - 1));
+    char host_buf[256] = {};
+    ::gethostname(host_buf, sizeof(host_buf) - 1);
+    std::string host = host_buf;
+    std::string pid = std::to_string(::getpid());
+    std::string stamp = "1760716800.123";
+
+    garda::LineFormat format;
+    std::string error;
+    if (!format.compile(kFormat, garda::kGreeting, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    std::printf("format \"%.*s\": %zu instructions, lines up to %zu bytes\n",
+                static_cast<int>(kFormat.size()), kFormat.data(), format.code().size(),
+                format.max_line());
+
+    std::string out;
+    out.reserve(kBatch * format.max_line());
+    std::size_t bytes = 0;
+    std::uint64_t before = heap_allocations.load();
+    auto start = Clock::now();
+    for (std::uint64_t n = 1; n <= lines; n += kBatch) {
+        out.resize(kBatch * format.max_line());
+        char *p = &out[0];
+        for (std::uint64_t i = 0; i < kBatch; ++i)
+            p = format.render(p, n + i, stamp, pid);
+        out.resize(static_cast<std::size_t>(p - out.data()));
+        bytes += out.size();
+    }
+    std::chrono::duration<double> dt = Clock::now() - start;
+    report("bytecode", lines, heap_allocations.load() - before, dt.count(), bytes);
+    std::string expected = out;
+
+    bytes = 0;
+    before = heap_allocations.load();
+    start = Clock::now();
+    for (std::uint64_t n = 1; n <= lines; n += kBatch) {
+        out.clear();
+        for (std::uint64_t i = 0; i < kBatch; ++i) {
+            std::string line = greeting + " from " + host + "[" + pid + "] #" +
+                               std::to_string(n + i) + " " + stamp + "\n";
+            out += line;
+        }
+        bytes += out.size();
+    }
+    dt = Clock::now() - start;
+    report("concatenation", lines, heap_allocations.load() - before, dt.count(), bytes);
+    bool same = out == expected;
+
+    bytes = 0;
+    before = heap_allocations.load();
+    start = Clock::now();
+    for (std::uint64_t n = 1; n <= lines; n += kBatch) {
+        out.clear();
+        for (std::uint64_t i = 0; i < kBatch; ++i) {
+            substitute(kFormat, out, [&](std::string_view field) -> std::string {
+                if (field == "greeting")
+                    return greeting;
+                if (field == "host")
+                    return host;
+                if (field == "pid")
+                    return pid;
+                if (field == "n")
+                    return std::to_string(n + i);
+                return stamp;
+            });
+        }
+        bytes += out.size();
+    }
+    dt = Clock::now() - start;
+    report("substitution", lines, heap_allocations.load() - before, dt.count(), bytes);
+    same = same && out == expected;
+    if (!same) {
+        std::fprintf(stderr, "renderers disagree\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,512 @@
+// Regression suite on Google Benchmark: start-up (spawn to exit of
+// Tets_GARDA), per-line output through OutputBuffer, batch output with
+// write_repeated() (both into a pipe a reader thread drains) and the
+// chunk fillers, and round trips to --serve-unix,
+// --serve-http and --zygote servers started from the same build.
+// All Google Benchmark flags apply; --benchmark_out=FILE writes the JSON.
+// Two flags of its own:
+//   --baseline=FILE   JSON written earlier with --benchmark_out; after the
+//                     run every benchmark is compared with it (the median
+//                     when run with repetitions)
+//   --threshold=F     allowed slowdown as a fraction (default 0.15); the
+//                     exit code is 1 if any benchmark got slower than that,
+//                     failed with an error, or is in the baseline but did
+//                     not report
+//   --allow-missing-baseline
+//                     exit 0 when the baseline file does not exist (it is
+//                     an error otherwise)
+//   --record-missing-baseline
+//                     when the baseline file does not exist, copy the
+//                     --benchmark_out results there instead of comparing
+// The garda_bench_check and garda_bench_baseline targets run it this way.
+
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+
+#include "batch.h"
+#include "fd_sink.h"
+#include "greeting.h"
+#include "line_format.h"
+#include "line_template.h"
+#include "output.h"
+#include "unix_service.h"
+#include "zygote.h"
+
+extern char **environ;
+
+namespace {
+
+constexpr char kBinary[] = GARDA_DEFAULT_BINARY;
+constexpr std::uint64_t kChunkLines = 64 * 1024;
+
+int dev_null() {
+    static int fd = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+    return fd;
+}
+
+pid_t spawn(const std::vector<std::string> &args, int out_fd) {
+    std::vector<char *> argv;
+    std::string binary = kBinary;
+    argv.push_back(&binary[0]);
+    std::vector<std::string> copy = args;
+    for (std::string &a : copy)
+        argv.push_back(&a[0]);
+    argv.push_back(nullptr);
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, out_fd, STDOUT_FILENO);
+    pid_t pid = -1;
+    if (posix_spawn(&pid, argv[0], &actions, nullptr, argv.data(), environ) != 0)
+        pid = -1;
+    posix_spawn_file_actions_destroy(&actions);
+    return pid;
+}
+
+// A pipe whose read end a thread drains with read(), as a consumer of
+// Tets_GARDA's stdout would; /dev/null would accept any write at no cost.
+// bytes() is what arrived, once the write end is closed.
+class DrainedPipe {
+public:
+    DrainedPipe() {
+        if (::pipe2(fds_, O_CLOEXEC) != 0) {
+            fds_[0] = fds_[1] = -1;
+            return;
+        }
+        ::fcntl(fds_[1], F_SETPIPE_SZ, 1 << 20);
+        reader_ = std::thread([this] {
+            std::unique_ptr<char[]> buf(new char[1 << 16]);
+            for (ssize_t n; (n = ::read(fds_[0], buf.get(), 1 << 16)) > 0;)
+                bytes_.fetch_add(static_cast<std::uint64_t>(n), std::memory_order_relaxed);
+        });
+    }
+    ~DrainedPipe() {
+        close_write();
+        if (fds_[0] >= 0)
+            ::close(fds_[0]);
+    }
+
+    int fd() const { return fds_[1]; }
+
+    std::uint64_t close_write() {
+        if (fds_[1] >= 0) {
+            ::close(fds_[1]);
+            fds_[1] = -1;
+            reader_.join();
+        }
+        return bytes_.load(std::memory_order_relaxed);
+    }
+
+private:
+    int fds_[2];
+    std::thread reader_;
+    std::atomic<std::uint64_t> bytes_{0};
+};
+
+int connect_tcp(int port) {
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(static_cast<std::uint16_t>(port));
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd >= 0 && ::connect(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+// A Tets_GARDA server for the lifetime of the process: started on first
+// use, stopped with SIGTERM at exit. connect() returns a new connection,
+// or -1; it is retried for up to two seconds while the server comes up.
+class Server {
+public:
+    Server(const std::vector<std::string> &args, std::function<int()> connect)
+        : connect_(std::move(connect)) {
+        pid_ = spawn(args, dev_null());
+        for (int i = 0; pid_ > 0 && i < 2000; ++i) {
+            int fd = connect_();
+            if (fd >= 0) {
+                ::close(fd);
+                up_ = true;
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    ~Server() {
+        if (pid_ > 0) {
+            ::kill(pid_, SIGTERM);
+            ::waitpid(pid_, nullptr, 0);
+        }
+    }
+
+    bool up() const { return up_; }
+    int connect() const { return connect_(); }
+
+private:
+    std::function<int()> connect_;
+    pid_t pid_ = -1;
+    bool up_ = false;
+};
+
+std::string socket_path(const char *kind) {
+    return "/tmp/garda-bench." + std::to_string(::getpid()) + "." + kind;
+}
+
+void BM_Startup(benchmark::State &state) {
+    for (auto _ : state) {
+        pid_t pid = spawn({}, dev_null());
+        int status = 0;
+        if (pid < 0 || ::waitpid(pid, &status, 0) != pid || status != 0) {
+            state.SkipWithError("Tets_GARDA did not run");
+            break;
+        }
+    }
+}
+BENCHMARK(BM_Startup)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+void BM_PerLine(benchmark::State &state) {
+    DrainedPipe pipe;
+    if (pipe.fd() < 0) {
+        state.SkipWithError("pipe failed");
+        return;
+    }
+    garda::FdSink sink(pipe.fd());
+    garda::OutputConfig config;
+    config.flush_on_exit = false;
+    garda::OutputBuffer out(sink, config);
+    for (auto _ : state)
+        out.append(garda::kGreeting);
+    out.flush();
+    auto bytes = state.iterations() * static_cast<std::int64_t>(garda::kGreeting.size());
+    if (pipe.close_write() != static_cast<std::uint64_t>(bytes))
+        state.SkipWithError("output lost");
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(bytes);
+}
+BENCHMARK(BM_PerLine)->UseRealTime();
+
+void BM_Batch(benchmark::State &state) {
+    DrainedPipe pipe;
+    if (pipe.fd() < 0) {
+        state.SkipWithError("pipe failed");
+        return;
+    }
+    auto lines = static_cast<std::uint64_t>(state.range(0));
+    for (auto _ : state) {
+        if (!garda::write_repeated(pipe.fd(), garda::kGreeting, lines)) {
+            state.SkipWithError("write failed");
+            break;
+        }
+    }
+    auto bytes = state.iterations() * state.range(0) *
+                 static_cast<std::int64_t>(garda::kGreeting.size());
+    if (pipe.close_write() != static_cast<std::uint64_t>(bytes) && !state.error_occurred())
+        state.SkipWithError("output lost");
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(bytes);
+}
+BENCHMARK(BM_Batch)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20)->UseRealTime();
+
+void run_chunks(benchmark::State &state, const garda::ChunkFiller &fill) {
+    std::string out;
+    std::uint64_t first = 0;
+    for (auto _ : state) {
+        out.clear();
+        fill(first, kChunkLines, out);
+        first += kChunkLines;
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(kChunkLines));
+}
+
+void BM_NumberedChunk(benchmark::State &state) {
+    garda::LineTemplate tmpl;
+    tmpl.sequence = true;
+    run_chunks(state, garda::template_filler(garda::kGreeting, tmpl));
+}
+BENCHMARK(BM_NumberedChunk)->Unit(benchmark::kMicrosecond);
+
+void BM_FormatChunk(benchmark::State &state) {
+    garda::LineFormat format;
+    std::string error;
+    if (!format.compile("{greeting} from {host}[{pid}] #{n} {time}", garda::kGreeting, error)) {
+        state.SkipWithError(error.c_str());
+        return;
+    }
+    run_chunks(state, garda::format_filler(format));
+}
+BENCHMARK(BM_FormatChunk)->Unit(benchmark::kMicrosecond);
+
+void BM_UnixRoundTrip(benchmark::State &state) {
+    static const std::string path = socket_path("sock");
+    static Server server({"--serve-unix", path, "--lang", "en"},
+                         [] { return garda::connect_unix(path); });
+    if (!server.up()) {
+        state.SkipWithError("--serve-unix did not come up");
+        return;
+    }
+    std::string reply, error;
+    for (auto _ : state) {
+        if (!garda::request_unix(path, reply, error) || reply != garda::kGreeting) {
+            state.SkipWithError("bad reply");
+            break;
+        }
+    }
+}
+BENCHMARK(BM_UnixRoundTrip)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+void BM_HttpRoundTrip(benchmark::State &state) {
+    static const int port = 20000 + ::getpid() % 20000;
+    static Server server({"--serve-http", std::to_string(port), "--threads", "1", "--lang", "en"},
+                         [] { return connect_tcp(port); });
+    int fd = server.up() ? server.connect() : -1;
+    if (fd < 0) {
+        state.SkipWithError("--serve-http did not come up");
+        return;
+    }
+    static constexpr std::string_view kRequest = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    std::string reply(garda::kHttpGreeting.size(), '\0');
+    for (auto _ : state) {
+        bool ok = ::send(fd, kRequest.data(), kRequest.size(), MSG_NOSIGNAL) ==
+                  static_cast<ssize_t>(kRequest.size());
+        for (std::size_t got = 0; ok && got < reply.size();) {
+            ssize_t n = ::read(fd, &reply[got], reply.size() - got);
+            ok = n > 0;
+            got += ok ? static_cast<std::size_t>(n) : 0;
+        }
+        if (!ok || reply != garda::kHttpGreeting) {
+            state.SkipWithError("bad reply");
+            break;
+        }
+    }
+    ::close(fd);
+}
+BENCHMARK(BM_HttpRoundTrip)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+void BM_ZygoteRoundTrip(benchmark::State &state) {
+    static const std::string path = socket_path("zygote");
+    static Server server({"--zygote", path, "--lang", "en"},
+                         [] { return garda::connect_unix(path); });
+    int conn = server.up() ? server.connect() : -1;
+    if (conn < 0) {
+        state.SkipWithError("--zygote did not come up");
+        return;
+    }
+    std::string error;
+    int pid = 0, status = 0;
+    for (auto _ : state) {
+        if (!garda::zygote_spawn(conn, dev_null(), 1, pid, status, error) || status != 0) {
+            state.SkipWithError(error.empty() ? "child failed" : error.c_str());
+            break;
+        }
+    }
+    ::close(conn);
+}
+BENCHMARK(BM_ZygoteRoundTrip)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+// Time per benchmark in nanoseconds, by run name: the median when there
+// are repetitions, otherwise the single run.
+using Timings = std::map<std::string, double>;
+// Error message by run name, for runs that called SkipWithError().
+using Errors = std::map<std::string, std::string>;
+
+double to_ns(double t, std::string_view unit) {
+    return unit == "s" ? t * 1e9 : unit == "ms" ? t * 1e6 : unit == "us" ? t * 1e3 : t;
+}
+
+void record(Timings &timings, const std::string &name, bool aggregate,
+            const std::string &aggregate_name, double ns) {
+    if (!aggregate)
+        timings.emplace(name, ns);
+    else if (aggregate_name == "median")
+        timings[name] = ns;
+}
+
+// Console output as usual, plus the timings and errors for the comparison.
+class RecordingReporter : public benchmark::ConsoleReporter {
+public:
+    RecordingReporter(Timings &timings, Errors &errors) : timings_(timings), errors_(errors) {}
+
+    void ReportRuns(const std::vector<Run> &runs) override {
+        for (const Run &r : runs) {
+            if (r.error_occurred)
+                errors_.emplace(r.run_name.str(), r.error_message);
+            else
+                record(timings_, r.run_name.str(), r.run_type == Run::RT_Aggregate,
+                       r.aggregate_name,
+                       to_ns(r.GetAdjustedRealTime(), benchmark::GetTimeUnitString(r.time_unit)));
+        }
+        ConsoleReporter::ReportRuns(runs);
+    }
+
+private:
+    Timings &timings_;
+    Errors &errors_;
+};
+
+// Value of "key": on a line of the JSON --benchmark_out writes, which has
+// one key per line; quotes and the trailing comma are dropped.
+bool json_field(const std::string &line, const char *key, std::string &value) {
+    std::string quoted = std::string("\"") + key + "\": ";
+    std::size_t at = line.find(quoted);
+    if (at == std::string::npos)
+        return false;
+    value = line.substr(at + quoted.size());
+    while (!value.empty() && (value.back() == ',' || std::isspace(static_cast<unsigned char>(
+                                                         value.back()))))
+        value.pop_back();
+    if (value.size() >= 2 && value.front() == '"')
+        value = value.substr(1, value.size() - 2);
+    return true;
+}
+
+bool read_baseline(const std::string &path, Timings &timings) {
+    std::ifstream in(path);
+    if (!in)
+        return false;
+    std::string line, name, run_name, run_type, aggregate_name, real_time, unit, value;
+    while (std::getline(in, line)) {
+        if (json_field(line, "name", value))
+            name = value;
+        else if (json_field(line, "run_name", value))
+            run_name = value;
+        else if (json_field(line, "run_type", value))
+            run_type = value;
+        else if (json_field(line, "aggregate_name", value))
+            aggregate_name = value;
+        else if (json_field(line, "real_time", value))
+            real_time = value;
+        else if (json_field(line, "time_unit", value))
+            unit = value;
+        else if (line.find('}') != std::string::npos) {
+            if (!real_time.empty())
+                record(timings, run_name.empty() ? name : run_name, run_type == "aggregate",
+                       aggregate_name, to_ns(std::strtod(real_time.c_str(), nullptr), unit));
+            name.clear();
+            run_name.clear();
+            run_type.clear();
+            aggregate_name.clear();
+            real_time.clear();
+            unit.clear();
+        }
+    }
+    return true;
+}
+
+// Prints every benchmark against the baseline; returns the number that
+// slowed down by more than threshold, failed, or are in the baseline but
+// produced no timing. With aggregates only, Google Benchmark reports
+// nothing for a benchmark whose repetitions all failed, so a missing
+// entry is the only trace of it.
+int compare(const Timings &now, const Errors &errors, const Timings &baseline,
+            double threshold) {
+    int regressions = 0;
+    for (const auto &[name, message] : errors) {
+        if (now.count(name))
+            continue;
+        ++regressions;
+        std::printf("%-32s FAILED: %s\n", name.c_str(), message.c_str());
+    }
+    for (const auto &[name, ns] : baseline) {
+        if (now.count(name) || errors.count(name))
+            continue;
+        ++regressions;
+        std::printf("%-32s %12.1f ns -> %15s  MISSING\n", name.c_str(), ns, "no result");
+    }
+    for (const auto &[name, ns] : now) {
+        auto it = baseline.find(name);
+        if (it == baseline.end()) {
+            std::printf("%-32s %14s %12.1f ns  (not in baseline)\n", name.c_str(), "", ns);
+            continue;
+        }
+        double change = ns / it->second - 1;
+        bool regressed = change > threshold;
+        regressions += regressed;
+        std::printf("%-32s %12.1f ns -> %12.1f ns  %+6.1f%%%s\n", name.c_str(), it->second, ns,
+                    change * 100, regressed ? "  REGRESSED" : "");
+    }
+    return regressions;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::string baseline;
+    double threshold = 0.15;
+    bool allow_missing_baseline = false;
+    bool record_missing_baseline = false;
+    std::string out_path;
+    int kept = 1;
+    for (int i = 1; i < argc; ++i) {
+        // Also passed on to Google Benchmark.
+        if (!std::strncmp(argv[i], "--benchmark_out=", 16))
+            out_path = argv[i] + 16;
+        if (!std::strncmp(argv[i], "--baseline=", 11))
+            baseline = argv[i] + 11;
+        else if (!std::strcmp(argv[i], "--allow-missing-baseline"))
+            allow_missing_baseline = true;
+        else if (!std::strcmp(argv[i], "--record-missing-baseline"))
+            record_missing_baseline = true;
+        else if (!std::strncmp(argv[i], "--threshold=", 12))
+            threshold = std::strtod(argv[i] + 12, nullptr);
+        else
+            argv[kept++] = argv[i];
+    }
+    argc = kept;
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 2;
+
+    Timings now;
+    Errors errors;
+    RecordingReporter reporter(now, errors);
+    benchmark::RunSpecifiedBenchmarks(&reporter);
+    benchmark::Shutdown();
+    if (baseline.empty())
+        return errors.empty() ? 0 : 1;
+
+    Timings before;
+    if (!read_baseline(baseline, before)) {
+        if (record_missing_baseline && !out_path.empty() && errors.empty()) {
+            std::ifstream from(out_path, std::ios::binary);
+            std::ofstream to(baseline, std::ios::binary);
+            if (from && to << from.rdbuf()) {
+                std::printf("\nno baseline at %s; recorded this run as the baseline\n",
+                            baseline.c_str());
+                return 0;
+            }
+        }
+        std::fprintf(stderr, "\nno baseline at %s; record one with the "
+                     "garda_bench_baseline target\n", baseline.c_str());
+        return allow_missing_baseline && errors.empty() ? 0 : 1;
+    }
+    std::printf("\nagainst %s, allowed slowdown %.0f%%:\n", baseline.c_str(), threshold * 100);
+    int regressions = compare(now, errors, before, threshold);
+    if (regressions)
+        std::printf("%d benchmark(s) regressed, failed or missing\n", regressions);
+    return regressions ? 1 : 0;
+}
@@ -0,0 +1,147 @@
+// wrk-style HTTP/1.1 load generator for Tets_GARDA --serve-http. Each
+// thread keeps one keep-alive connection and sends batches of pipelined
+// GET requests, waiting for all replies before the next batch.
+// Usage: http_load PORT [connections] [seconds] [pipeline]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr char kRequest[] = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+struct Result {
+    std::vector<float> batch_usec;
+    unsigned long requests = 0;
+    bool failed = false;
+};
+
+bool write_all(int fd, const char *p, std::size_t n) {
+    while (n > 0) {
+        ssize_t w = ::write(fd, p, n);
+        if (w <= 0)
+            return false;
+        p += w;
+        n -= static_cast<std::size_t>(w);
+    }
+    return true;
+}
+
+// Reads exactly n bytes into buf (reusing its storage).
+bool read_exact(int fd, std::vector<char> &buf, std::size_t n) {
+    buf.resize(n);
+    for (std::size_t got = 0; got < n;) {
+        ssize_t r = ::read(fd, buf.data() + got, n - got);
+        if (r <= 0)
+            return false;
+        got += static_cast<std::size_t>(r);
+    }
+    return true;
+}
+
+// Issues one request and works out the size of a full response from its
+// headers; every later response has the same size.
+std::size_t probe_response_size(int fd) {
+    if (!write_all(fd, kRequest, sizeof(kRequest) - 1))
+        return 0;
+    std::string head;
+    char c;
+    while (head.size() < 8192 && head.find("\r\n\r\n") == std::string::npos) {
+        if (::read(fd, &c, 1) != 1)
+            return 0;
+        head += c;
+    }
+    std::size_t at = head.find("Content-Length:");
+    if (at == std::string::npos)
+        return 0;
+    std::size_t body = std::strtoul(head.c_str() + at + 15, nullptr, 10);
+    std::vector<char> rest;
+    return read_exact(fd, rest, body) ? head.size() + body : 0;
+}
+
+void client(const sockaddr_in &addr, Clock::time_point deadline, int pipeline, Result &r) {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0) {
+        std::perror("connect");
+        r.failed = true;
+        if (fd >= 0)
+            ::close(fd);
+        return;
+    }
+    std::size_t response = probe_response_size(fd);
+    std::string batch;
+    for (int i = 0; i < pipeline; ++i)
+        batch += kRequest;
+    std::vector<char> in;
+    r.batch_usec.reserve(1 << 18);
+    while (response && Clock::now() < deadline) {
+        auto start = Clock::now();
+        if (!write_all(fd, batch.data(), batch.size()) ||
+            !read_exact(fd, in, response * static_cast<std::size_t>(pipeline))) {
+            r.failed = true;
+            break;
+        }
+        std::chrono::duration<float, std::micro> dt = Clock::now() - start;
+        r.batch_usec.push_back(dt.count());
+        r.requests += static_cast<unsigned long>(pipeline);
+    }
+    r.failed = r.failed || !response;
+    ::close(fd);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s PORT [connections] [seconds] [pipeline]\n", argv[0]);
+        return 2;
+    }
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<std::uint16_t>(std::atoi(argv[1])));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int connections = argc > 2 ? std::atoi(argv[2]) : 4;
+    double seconds = argc > 3 ? std::atof(argv[3]) : 3.0;
+    int pipeline = argc > 4 ? std::max(1, std::atoi(argv[4])) : 1;
+    auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                       std::chrono::duration<double>(seconds));
+
+    std::vector<Result> results(static_cast<std::size_t>(connections));
+    std::vector<std::thread> threads;
+    for (Result &r : results)
+        threads.emplace_back(client, std::cref(addr), deadline, pipeline, std::ref(r));
+    for (std::thread &t : threads)
+        t.join();
+
+    std::vector<float> all;
+    unsigned long requests = 0;
+    for (const Result &r : results) {
+        if (r.failed)
+            std::fprintf(stderr, "warning: a connection failed\n");
+        all.insert(all.end(), r.batch_usec.begin(), r.batch_usec.end());
+        requests += r.requests;
+    }
+    if (all.empty())
+        return 1;
+    std::sort(all.begin(), all.end());
+    auto pct = [&](double p) { return all[static_cast<std::size_t>(p * (all.size() - 1))]; };
+    std::printf("connections %d, pipeline %d\n", connections, pipeline);
+    std::printf("requests    %lu\n", requests);
+    std::printf("rate        %.0f req/s\n", static_cast<double>(requests) / seconds);
+    std::printf("batch p50   %.1f us\n", pct(0.50));
+    std::printf("batch p99   %.1f us\n", pct(0.99));
+    return 0;
+}
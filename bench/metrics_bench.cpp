@@ -0,0 +1,130 @@
+// Cost of recording server metrics. Times a simulated event loop with and
+// without what the TCP server adds: two clock reads per epoll_wait() round
+// and a few single-writer stores per request, for rounds of 1, 4 and 16
+// requests, against the cheapest possible round: one write() and one
+// read() on a socketpair (a real round adds epoll_wait() and the TCP
+// stack, so the percentage per request is an upper bound). Then runs N recording threads against a scraper that renders
+// every millisecond and checks that the merged totals are exact. For the
+// end-to-end overhead on a live server see bench/metrics_overhead.sh.
+// Usage: metrics_bench [samples] [threads]
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "metrics.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Stands in for the per-request work the metrics are compared against.
+std::uint64_t serve(std::uint64_t x) {
+    return x * 6364136223846793005ull + 1442695040888963407ull;
+}
+
+double ns_per_request(std::uint64_t samples, unsigned per_round, garda::MetricsShard *shard) {
+    std::uint64_t x = 1;
+    auto start = Clock::now();
+    for (std::uint64_t i = 0; i < samples; i += per_round) {
+        std::uint64_t woke = shard ? garda::monotonic_ns() : 0;
+        for (unsigned r = 0; r < per_round; ++r) {
+            x = serve(x);
+            if (shard)
+                shard->add_bytes(x & 127);
+        }
+        if (shard)
+            shard->observe(garda::monotonic_ns() - woke, per_round);
+    }
+    std::chrono::duration<double> dt = Clock::now() - start;
+    if (x == 42)
+        std::puts("");
+    return dt.count() * 1e9 / static_cast<double>(samples);
+}
+
+double socketpair_round_ns() {
+    int sv[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0)
+        return 0;
+    char buf[128] = {};
+    constexpr int kRounds = 200000;
+    auto start = Clock::now();
+    for (int i = 0; i < kRounds; ++i) {
+        if (::write(sv[0], buf, 64) != 64 || ::read(sv[1], buf, sizeof(buf)) != 64)
+            break;
+    }
+    std::chrono::duration<double> dt = Clock::now() - start;
+    ::close(sv[0]);
+    ::close(sv[1]);
+    return dt.count() * 1e9 / kRounds;
+}
+
+std::uint64_t parse_total(const std::string &text, const std::string &name) {
+    std::size_t at = text.find("\n" + name + " ");
+    if (at == std::string::npos)
+        return 0;
+    return std::strtoull(text.c_str() + at + name.size() + 2, nullptr, 10);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::uint64_t samples = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000000;
+    unsigned threads = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : 4;
+
+    garda::Metrics single(1);
+    double round = socketpair_round_ns();
+    std::printf("socketpair write+read round: %.0f ns\n", round);
+    std::printf("requests/round  added ns/request  overhead\n");
+    for (unsigned per_round : {1u, 4u, 16u}) {
+        double bare = ns_per_request(samples, per_round, nullptr);
+        double added = ns_per_request(samples, per_round, &single.shard(0)) - bare;
+        std::printf("%14u  %16.2f  %7.2f%%\n", per_round, added, added / round * 100);
+    }
+
+    garda::Metrics metrics(threads);
+    std::atomic<bool> done{false};
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; ++t)
+        pool.emplace_back([&, t] {
+            garda::MetricsShard &shard = metrics.shard(t);
+            for (std::uint64_t i = 0; i < samples / threads; ++i) {
+                shard.add_bytes(13);
+                shard.observe(i & 0xfffff);
+            }
+        });
+    unsigned scrapes = 0;
+    double scrape_us = 0;
+    std::thread scraper([&] {
+        while (!done.load()) {
+            auto start = Clock::now();
+            std::string text = metrics.render();
+            scrape_us += std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+            ++scrapes;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    for (std::thread &t : pool)
+        t.join();
+    done = true;
+    scraper.join();
+
+    std::string text = metrics.render();
+    std::uint64_t expect = samples / threads * threads;
+    std::uint64_t requests = parse_total(text, "garda_requests_total");
+    std::uint64_t bytes = parse_total(text, "garda_sent_bytes_total");
+    std::uint64_t count = parse_total(text, "garda_request_duration_seconds_count");
+    std::printf("%u threads, %u scrapes while recording, %.1f us per scrape\n", threads, scrapes,
+                scrapes ? scrape_us / scrapes : 0.0);
+    bool ok = requests == expect && count == expect && bytes == expect * 13;
+    std::printf("merged totals     %s\n", ok ? "exact" : "MISMATCH");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,33 @@
+#!/bin/sh
+# Measures the cost of --metrics-port on a live server: runs
+# Tets_GARDA --serve-http with and without metrics, alternating, and loads
+# each with http_load over one connection without pipelining, the worst
+# case for metrics (two clock reads per request).
+# Usage: bench/metrics_overhead.sh BUILD_DIR [port] [seconds] [rounds]
+set -e
+build=${1:?usage: $0 BUILD_DIR [port] [seconds] [rounds]}
+port=${2:-18080}
+seconds=${3:-3}
+rounds=${4:-5}
+metrics_port=$((port + 1))
+
+run() {
+    "$build/Tets_GARDA" --serve-http "$port" --threads 1 "$@" &
+    server=$!
+    sleep 0.3
+    rate=$("$build/http_load" "$port" 1 "$seconds" 1 | awk '/^rate/ { print $2 }')
+    kill "$server"
+    wait "$server" || true
+    echo "$rate"
+}
+
+off=0
+on=0
+for i in $(seq "$rounds"); do
+    a=$(run)
+    b=$(run --metrics-port "$metrics_port")
+    echo "round $i: without $a req/s, with $b req/s"
+    off=$((off + a))
+    on=$((on + b))
+done
+awk -v off="$off" -v on="$on" 'BEGIN { printf "overhead %.2f%%\n", (off - on) * 100 / off }'
@@ -0,0 +1,29 @@
+#!/bin/sh
+# Compares fixture generation through shell redirection with --output-file.
+# Usage: bench/mmap_bench.sh BUILD_DIR [lines] [dir]
+set -e
+build=${1:?usage: $0 BUILD_DIR [lines] [dir]}
+lines=${2:-100000000}
+dir=${3:-.}
+bin="$build/Tets_GARDA"
+out="$dir/garda_fixture.txt"
+
+now() { date +%s.%N; }
+
+report() {
+    bytes=$(wc -c <"$out")
+    awk -v name="$1" -v t0="$2" -v t1="$3" -v b="$bytes" \
+        'BEGIN { printf "%-22s %8.3f s %7.3f GB/s\n", name, t1 - t0, b / (t1 - t0) / 1e9 }'
+}
+
+t0=$(now); "$bin" --count "$lines" >"$out"; t1=$(now)
+report "redirect (writev)" "$t0" "$t1"
+reference=$(md5sum <"$out")
+
+for threads in 1 $(nproc); do
+    rm -f "$out"
+    t0=$(now); "$bin" --count "$lines" --output-file "$out" --threads "$threads"; t1=$(now)
+    report "mmap, $threads thread(s)" "$t0" "$t1"
+    [ "$(md5sum <"$out")" = "$reference" ] || { echo "output differs" >&2; exit 1; }
+done
+rm -f "$out"
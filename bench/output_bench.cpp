@@ -0,0 +1,111 @@
+// Compares per-line std::endl flushing against garda::OutputBuffer.
+// Usage: output_bench [lines] [buffer-bytes]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ostream>
+#include <streambuf>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "output.h"
+#include "stream_sink.h"
+
+namespace {
+
+// Minimal fd-backed streambuf that counts the write(2) calls it makes, so
+// both variants are measured against the same device.
+class CountingFdBuf : public std::streambuf {
+public:
+    explicit CountingFdBuf(int fd) : fd_(fd) { setp(buf_, buf_ + sizeof(buf_)); }
+
+    long syscalls = 0;
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (drain() != 0)
+            return traits_type::eof();
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    std::streamsize xsputn(const char *s, std::streamsize n) override {
+        if (n > epptr() - pptr()) {
+            if (drain() != 0)
+                return 0;
+            if (n >= static_cast<std::streamsize>(sizeof(buf_))) {
+                ++syscalls;
+                return ::write(fd_, s, static_cast<std::size_t>(n));
+            }
+        }
+        traits_type::copy(pptr(), s, static_cast<std::size_t>(n));
+        pbump(static_cast<int>(n));
+        return n;
+    }
+
+    int sync() override { return drain(); }
+
+private:
+    int drain() {
+        std::ptrdiff_t n = pptr() - pbase();
+        if (n > 0) {
+            ++syscalls;
+            if (::write(fd_, pbase(), static_cast<std::size_t>(n)) != n)
+                return -1;
+        }
+        setp(buf_, buf_ + sizeof(buf_));
+        return 0;
+    }
+
+    int fd_;
+    char buf_[8192];
+};
+
+void report(const char *name, long lines, long syscalls, double seconds) {
+    std::printf("%-14s %12.0f lines/s %10.6f syscalls/line\n", name, lines / seconds,
+                static_cast<double>(syscalls) / static_cast<double>(lines));
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    long lines = argc > 1 ? std::atol(argv[1]) : 1000000;
+    std::size_t capacity = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 64 * 1024;
+    int fd = ::open("/dev/null", O_WRONLY);
+    if (fd < 0) {
+        std::perror("/dev/null");
+        return 1;
+    }
+
+    using clock = std::chrono::steady_clock;
+    {
+        CountingFdBuf buf(fd);
+        std::ostream os(&buf);
+        auto start = clock::now();
+        for (long i = 0; i < lines; ++i)
+            os << "Hello world!" << std::endl;
+        std::chrono::duration<double> dt = clock::now() - start;
+        report("endl", lines, buf.syscalls, dt.count());
+    }
+    {
+        CountingFdBuf buf(fd);
+        std::ostream os(&buf);
+        garda::StreamSink sink(os);
+        garda::OutputConfig config;
+        config.capacity = capacity;
+        garda::OutputBuffer out(sink, config);
+        auto start = clock::now();
+        for (long i = 0; i < lines; ++i)
+            out.append("Hello world!\n");
+        out.flush();
+        std::chrono::duration<double> dt = clock::now() - start;
+        report("OutputBuffer", lines, buf.syscalls, dt.count());
+    }
+    ::close(fd);
+    return 0;
+}
@@ -0,0 +1,70 @@
+// Scaling benchmark for generate_parallel(): renders N lines with 1..64
+// filler threads into a hashing sink, reports GB/s and checks that every
+// run is byte-identical to the single-threaded output.
+// Usage: parallel_bench [lines] [max-threads]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "greeting.h"
+#include "output.h"
+#include "parallel_gen.h"
+
+namespace {
+
+// Consumes output in order, keeping an FNV-style hash over 8-byte words.
+// Chunk sizes do not depend on the thread count, so equal output gives
+// equal hashes.
+class HashSink : public garda::Sink {
+public:
+    bool write(const char *data, std::size_t n) override {
+        ++writes_;
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            std::uint64_t word;
+            std::memcpy(&word, data + i, 8);
+            hash_ = (hash_ ^ word) * 1099511628211ull;
+        }
+        for (; i < n; ++i)
+            hash_ = (hash_ ^ static_cast<unsigned char>(data[i])) * 1099511628211ull;
+        bytes_ += n;
+        return true;
+    }
+
+    std::uint64_t hash() const { return hash_; }
+    std::uint64_t bytes() const { return bytes_; }
+
+private:
+    std::uint64_t hash_ = 14695981039346656037ull;
+    std::uint64_t bytes_ = 0;
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::uint64_t lines = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000000;
+    unsigned max_threads = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : 64;
+    garda::ChunkFiller fill = garda::repeat_filler(garda::kGreeting);
+
+    std::uint64_t reference = 0;
+    double base = 0;
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        HashSink sink;
+        garda::ParallelConfig config;
+        config.threads = threads;
+        auto start = std::chrono::steady_clock::now();
+        garda::generate_parallel(sink, lines, fill, config);
+        std::chrono::duration<double> dt = std::chrono::steady_clock::now() - start;
+        if (threads == 1) {
+            reference = sink.hash();
+            base = dt.count();
+        }
+        std::printf("%3u threads %7.3f GB/s  speedup %5.2fx  %s\n", threads,
+                    sink.bytes() / dt.count() / 1e9, base / dt.count(),
+                    sink.hash() == reference ? "identical" : "MISMATCH");
+    }
+    return 0;
+}
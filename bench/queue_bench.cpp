@@ -0,0 +1,170 @@
+// Throughput and producer-side tail latency of QueuedWriter (lock-free MPSC
+// queue + writer thread) against producers that share one OutputBuffer
+// behind a mutex, as threads sharing std::cout would. Each producer writes
+// "p<id> #<n>\n" lines; the sink parses every line and checks that no
+// line is torn and each producer's lines arrive in order.
+// Usage: queue_bench [lines-per-producer] [max-producers]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "int_format.h"
+#include "line_queue.h"
+#include "output.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Every 16th push is timed; the clock would dominate otherwise.
+constexpr std::uint64_t kSampleEvery = 16;
+
+class CheckSink : public garda::Sink {
+public:
+    explicit CheckSink(unsigned producers) : next_(producers, 1) {}
+
+    bool write(const char *data, std::size_t n) override {
+        ++writes_;
+        const char *end = data + n;
+        while (data < end) {
+            const char *nl = static_cast<const char *>(std::memchr(data, '\n', end - data));
+            if (!nl) {
+                line_.append(data, end);
+                break;
+            }
+            line_.append(data, nl);
+            check(line_);
+            line_.clear();
+            data = nl + 1;
+        }
+        return true;
+    }
+
+    bool ok() const { return ok_ && line_.empty(); }
+    std::uint64_t lines() const { return lines_; }
+
+private:
+    void check(const std::string &line) {
+        ++lines_;
+        std::size_t hash = line.find(" #");
+        if (line.size() < 4 || line[0] != 'p' || hash == std::string::npos) {
+            ok_ = false;
+            return;
+        }
+        unsigned id = static_cast<unsigned>(std::strtoul(line.c_str() + 1, nullptr, 10));
+        std::uint64_t n = std::strtoull(line.c_str() + hash + 2, nullptr, 10);
+        if (id >= next_.size() || n != next_[id]++)
+            ok_ = false;
+    }
+
+    std::vector<std::uint64_t> next_;
+    std::string line_;
+    std::uint64_t lines_ = 0;
+    bool ok_ = true;
+};
+
+struct Result {
+    double seconds = 0;
+    std::vector<std::uint64_t> samples;
+};
+
+// Runs producers that call emit(line) for lines lines each, then finish();
+// the time covers both.
+template <typename Emit, typename Finish>
+Result run(unsigned producers, std::uint64_t lines, Emit emit, Finish finish) {
+    std::vector<std::vector<std::uint64_t>> samples(producers);
+    std::vector<std::thread> pool;
+    auto start = Clock::now();
+    for (unsigned p = 0; p < producers; ++p)
+        pool.emplace_back([&, p] {
+            char line[64] = "p";
+            std::size_t id_len = 1 + garda::format_decimal(p, line + 1);
+            line[id_len] = ' ';
+            line[id_len + 1] = '#';
+            samples[p].reserve(lines / kSampleEvery + 1);
+            for (std::uint64_t n = 1; n <= lines; ++n) {
+                std::size_t len = id_len + 2 + garda::format_decimal(n, line + id_len + 2);
+                line[len++] = '\n';
+                if (n % kSampleEvery) {
+                    emit(std::string_view(line, len));
+                    continue;
+                }
+                auto t0 = Clock::now();
+                emit(std::string_view(line, len));
+                samples[p].push_back(static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count()));
+            }
+        });
+    for (std::thread &t : pool)
+        t.join();
+    finish();
+    Result r;
+    r.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    for (auto &s : samples)
+        r.samples.insert(r.samples.end(), s.begin(), s.end());
+    std::sort(r.samples.begin(), r.samples.end());
+    return r;
+}
+
+void report(const char *mode, unsigned producers, std::uint64_t lines, const Result &r,
+            const CheckSink &sink) {
+    auto pct = [&](double q) {
+        if (r.samples.empty())
+            return std::uint64_t(0);
+        return r.samples[static_cast<std::size_t>(q * static_cast<double>(r.samples.size() - 1))];
+    };
+    std::printf("%-7s %3u producers %7.2f Mlines/s  push p50 %6llu ns  p99 %7llu ns  "
+                "p99.9 %8llu ns  max %9llu ns  %s\n",
+                mode, producers, static_cast<double>(lines) / r.seconds / 1e6,
+                static_cast<unsigned long long>(pct(0.5)), static_cast<unsigned long long>(pct(0.99)),
+                static_cast<unsigned long long>(pct(0.999)),
+                static_cast<unsigned long long>(r.samples.empty() ? 0 : r.samples.back()),
+                sink.ok() && sink.lines() == lines ? "ordered" : "CORRUPT");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::uint64_t per_producer = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    unsigned max_producers = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : 16;
+    bool ok = true;
+
+    for (unsigned producers = 1; producers <= max_producers; producers *= 2) {
+        std::uint64_t total = per_producer * producers;
+        {
+            CheckSink sink(producers);
+            garda::QueuedWriter writer(sink);
+            Result r = run(
+                producers, per_producer, [&](std::string_view line) { writer.push(line); },
+                [&] { ok = writer.close() && ok; });
+            report("queue", producers, total, r, sink);
+            ok = ok && sink.ok();
+        }
+        {
+            CheckSink sink(producers);
+            std::mutex mu;
+            garda::OutputConfig config;
+            config.capacity = 256 * 1024;
+            config.flush_on_exit = false;
+            garda::OutputBuffer out(sink, config);
+            Result r = run(
+                producers, per_producer,
+                [&](std::string_view line) {
+                    std::lock_guard<std::mutex> lock(mu);
+                    out.append(line);
+                },
+                [&] { out.flush(); });
+            report("mutex", producers, total, r, sink);
+            ok = ok && sink.ok();
+        }
+    }
+    return ok ? 0 : 1;
+}
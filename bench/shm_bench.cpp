@@ -0,0 +1,294 @@
+// Shared-memory greeting channel against a pipe between two processes.
+// Throughput: the parent sends N numbered greeting lines and a forked
+// reader checks that every line arrives once and in order; messages/sec
+// run from the first send to the reader taking the last line. The channel
+// wakes sleeping readers after every line or every 1024 lines. The pipe is
+// driven both the naive way (one write() per line) and the way Tets_GARDA
+// writes stdout (64 KiB blocks). Latency: the parent sends timestamped
+// lines with a pause between them, so the reader is usually asleep, and
+// the reader records send-to-receive time per line.
+// Usage: shm_bench [messages] [latency-samples]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "greeting.h"
+#include "int_format.h"
+#include "metrics.h"
+#include "shm_channel.h"
+
+namespace {
+
+struct Result {
+    std::uint64_t end_ns = 0;
+    std::uint64_t messages = 0;
+    std::uint64_t lost = 0;
+    bool ok = true;
+    std::uint64_t p50 = 0, p99 = 0, p999 = 0, max = 0;
+};
+
+// Checks "<greeting> #<n>" lines or records latency of "t<ns>" lines.
+class Receiver {
+public:
+    explicit Receiver(bool latency) : latency_(latency) {
+        if (latency)
+            samples_.reserve(1 << 20);
+    }
+
+    void take(std::string_view line) {
+        ++r_.messages;
+        if (latency_) {
+            std::uint64_t now = garda::monotonic_ns();
+            std::uint64_t sent = std::strtoull(std::string(line.substr(1)).c_str(), nullptr, 10);
+            samples_.push_back(now - sent);
+            return;
+        }
+        std::size_t hash = line.rfind('#');
+        if (hash == std::string_view::npos || line.back() != '\n') {
+            r_.ok = false;
+            return;
+        }
+        std::uint64_t n = 0;
+        for (std::size_t i = hash + 1; i + 1 < line.size(); ++i)
+            n = n * 10 + static_cast<std::uint64_t>(line[i] - '0');
+        if (n != ++expected_)
+            r_.ok = false;
+    }
+
+    Result finish(std::uint64_t lost) {
+        r_.end_ns = garda::monotonic_ns();
+        r_.lost = lost;
+        if (!samples_.empty()) {
+            std::sort(samples_.begin(), samples_.end());
+            auto pct = [&](double q) {
+                double last = static_cast<double>(samples_.size() - 1);
+                return samples_[static_cast<std::size_t>(q * last)];
+            };
+            r_.p50 = pct(0.5);
+            r_.p99 = pct(0.99);
+            r_.p999 = pct(0.999);
+            r_.max = samples_.back();
+        }
+        return r_;
+    }
+
+private:
+    bool latency_;
+    std::uint64_t expected_ = 0;
+    std::vector<std::uint64_t> samples_;
+    Result r_;
+};
+
+// Runs reader(result_fd) in a child process and returns its Result.
+template <typename Reader>
+pid_t fork_reader(Reader reader, int &result_fd) {
+    int fds[2];
+    if (::pipe(fds) != 0) {
+        std::perror("pipe");
+        std::exit(1);
+    }
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        ::close(fds[0]);
+        Result r = reader();
+        ssize_t w = ::write(fds[1], &r, sizeof r);
+        ::_exit(w == static_cast<ssize_t>(sizeof r) ? 0 : 1);
+    }
+    ::close(fds[1]);
+    result_fd = fds[0];
+    return pid;
+}
+
+Result collect(pid_t pid, int result_fd) {
+    Result r;
+    r.ok = ::read(result_fd, &r, sizeof r) == static_cast<ssize_t>(sizeof r);
+    ::close(result_fd);
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    r.ok = r.ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    return r;
+}
+
+std::size_t render(char *buf, bool latency, std::uint64_t n) {
+    std::size_t len;
+    if (latency) {
+        buf[0] = 't';
+        len = 1 + garda::format_decimal(garda::monotonic_ns(), buf + 1);
+    } else {
+        std::size_t g = garda::kGreeting.size() - 1;
+        std::memcpy(buf, garda::kGreeting.data(), g);
+        buf[g] = ' ';
+        buf[g + 1] = '#';
+        len = g + 2 + garda::format_decimal(n, buf + g + 2);
+    }
+    buf[len++] = '\n';
+    return len;
+}
+
+void pause_between(bool latency) {
+    if (latency)
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+}
+
+// Notifies sleeping readers after every message, or after every batch
+// lines as ShmSink does per write().
+Result run_shm(std::uint64_t messages, bool latency, std::uint64_t batch,
+               std::uint64_t &start_ns) {
+    std::string name = "garda_shm_bench." + std::to_string(::getpid());
+    std::string error;
+    garda::ShmWriter writer;
+    if (!writer.create(name, 16384, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        std::exit(1);
+    }
+    int result_fd;
+    pid_t pid = fork_reader(
+        [&] {
+            garda::ShmReader reader;
+            std::string err;
+            if (!reader.open(name, err)) {
+                std::fprintf(stderr, "%s\n", err.c_str());
+                return Result{0, 0, 0, false};
+            }
+            Receiver rx(latency);
+            std::string_view msg;
+            while (reader.read(msg) == garda::ShmReader::Status::Message)
+                rx.take(msg);
+            return rx.finish(reader.lost());
+        },
+        result_fd);
+    writer.wait_for_readers(1);
+    char buf[64];
+    start_ns = garda::monotonic_ns();
+    for (std::uint64_t n = 1; n <= messages; ++n) {
+        writer.put(std::string_view(buf, render(buf, latency, n)));
+        if (n % batch == 0)
+            writer.notify();
+        pause_between(latency);
+    }
+    writer.close();
+    Result r = collect(pid, result_fd);
+    std::string path = "/dev/shm/" + name;
+    ::unlink(path.c_str());
+    return r;
+}
+
+Result run_pipe(std::uint64_t messages, bool latency, bool batched, std::uint64_t &start_ns) {
+    int fds[2];
+    if (::pipe(fds) != 0) {
+        std::perror("pipe");
+        std::exit(1);
+    }
+    int result_fd;
+    pid_t pid = fork_reader(
+        [&] {
+            ::close(fds[1]);
+            Receiver rx(latency);
+            std::vector<char> buf(64 * 1024);
+            std::string partial;
+            for (;;) {
+                ssize_t got = ::read(fds[0], buf.data(), buf.size());
+                if (got <= 0)
+                    break;
+                const char *p = buf.data(), *end = p + got;
+                while (p < end) {
+                    const char *nl = static_cast<const char *>(std::memchr(p, '\n', end - p));
+                    if (!nl) {
+                        partial.append(p, end);
+                        break;
+                    }
+                    if (partial.empty()) {
+                        rx.take(std::string_view(p, static_cast<std::size_t>(nl + 1 - p)));
+                    } else {
+                        partial.append(p, nl + 1);
+                        rx.take(partial);
+                        partial.clear();
+                    }
+                    p = nl + 1;
+                }
+            }
+            return rx.finish(0);
+        },
+        result_fd);
+    ::close(fds[0]);
+    std::string block;
+    block.reserve(64 * 1024 + 64);
+    char buf[64];
+    start_ns = garda::monotonic_ns();
+    for (std::uint64_t n = 1; n <= messages; ++n) {
+        std::size_t len = render(buf, latency, n);
+        if (!batched) {
+            if (::write(fds[1], buf, len) != static_cast<ssize_t>(len))
+                std::perror("write");
+            pause_between(latency);
+            continue;
+        }
+        block.append(buf, len);
+        if (block.size() >= 64 * 1024) {
+            if (::write(fds[1], block.data(), block.size()) != static_cast<ssize_t>(block.size()))
+                std::perror("write");
+            block.clear();
+        }
+    }
+    if (!block.empty() &&
+        ::write(fds[1], block.data(), block.size()) != static_cast<ssize_t>(block.size()))
+        std::perror("write");
+    ::close(fds[1]);
+    return collect(pid, result_fd);
+}
+
+bool report_throughput(const char *name, std::uint64_t messages, const Result &r,
+                       std::uint64_t start_ns) {
+    bool ok = r.ok && r.messages == messages && r.lost == 0;
+    double sec = static_cast<double>(r.end_ns - start_ns) / 1e9;
+    double n = static_cast<double>(messages);
+    std::printf("%-21s %9.2f M msg/s  %6.1f ns/msg  %s\n", name, n / sec / 1e6, sec * 1e9 / n,
+                ok ? "in order" : "LOST OR REORDERED");
+    return ok;
+}
+
+bool report_latency(const char *name, std::uint64_t messages, const Result &r) {
+    bool ok = r.ok && r.messages == messages;
+    std::printf("%-21s p50 %7.1f us  p99 %7.1f us  p99.9 %8.1f us  max %8.1f us%s\n", name,
+                static_cast<double>(r.p50) / 1e3, static_cast<double>(r.p99) / 1e3,
+                static_cast<double>(r.p999) / 1e3, static_cast<double>(r.max) / 1e3,
+                ok ? "" : "  LOST");
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::uint64_t messages = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 5000000;
+    std::uint64_t samples = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 10000;
+    bool ok = true;
+    std::uint64_t start = 0;
+
+    std::printf("throughput, %llu greeting lines\n", static_cast<unsigned long long>(messages));
+    Result r = run_shm(messages, false, 1, start);
+    ok = report_throughput("shm, notify per line", messages, r, start) && ok;
+    r = run_shm(messages, false, 1024, start);
+    ok = report_throughput("shm, notify per 1024", messages, r, start) && ok;
+    r = run_pipe(messages, false, true, start);
+    ok = report_throughput("pipe, 64 KiB writes", messages, r, start) && ok;
+    r = run_pipe(messages, false, false, start);
+    ok = report_throughput("pipe, write per line", messages, r, start) && ok;
+
+    std::printf("latency, %llu lines 50 us apart\n", static_cast<unsigned long long>(samples));
+    r = run_shm(samples, true, 1, start);
+    ok = report_latency("shm channel", samples, r) && ok;
+    r = run_pipe(samples, true, false, start);
+    ok = report_latency("pipe", samples, r) && ok;
+    return ok ? 0 : 1;
+}
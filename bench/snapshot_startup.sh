@@ -0,0 +1,33 @@
+#!/bin/sh
+# Cold-start cost with and without a snapshot as the catalog grows: for
+# catalogs of 100 to 100000 generated languages, startup_bench times
+# "--catalog FILE --lang CODE" (read and index the file, render the reply)
+# against "--snapshot FILE" (map it; the reply is already rendered) and
+# "--snapshot FILE --lang CODE" (one probe of the stored index). The code
+# looked up is the last one in the file.
+# Usage: bench/snapshot_startup.sh BUILD_DIR [runs]
+# BUILD_DIR is a configured build with Tets_GARDA and startup_bench built.
+set -e
+build=${1:?usage: $0 BUILD_DIR [runs]}
+runs=${2:-1000}
+bin="$build/Tets_GARDA"
+bench="$build/startup_bench"
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+echo "== compiled-in catalog only"
+"$bench" -n "$runs" "$bin" --lang de
+for n in 100 1000 10000 100000; do
+    awk -v n=$n 'BEGIN { for (i = 1; i <= n; ++i) printf "x%d\tGreeting number %d!\n", i, i }' \
+        >"$work/cat.tsv"
+    "$bin" --catalog "$work/cat.tsv" --lang x$n --write-snapshot "$work/snap"
+    echo
+    echo "== $n entries: catalog $(wc -c <"$work/cat.tsv") bytes," \
+        "snapshot $(wc -c <"$work/snap") bytes"
+    echo "-- --catalog --lang x$n"
+    "$bench" -n "$runs" "$bin" --catalog "$work/cat.tsv" --lang x$n
+    echo "-- --snapshot"
+    "$bench" -n "$runs" "$bin" --snapshot "$work/snap"
+    echo "-- --snapshot --lang x$n"
+    "$bench" -n "$runs" "$bin" --snapshot "$work/snap" --lang x$n
+done
@@ -0,0 +1,61 @@
+// Streams N greetings into a pipe whose other end is spliced into /dev/null,
+// comparing writev() against vmsplice() output. Reports GB/s.
+// Usage: splice_bench [lines]   (default: 500000000)
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "batch.h"
+#include "greeting.h"
+#include "splice_out.h"
+
+namespace {
+
+// Moves everything from the pipe to /dev/null without copying to userspace.
+void drain_to_null(int in) {
+    int null = ::open("/dev/null", O_WRONLY);
+    while (::splice(in, nullptr, null, nullptr, 1 << 20, SPLICE_F_MOVE) > 0) {
+    }
+    ::close(null);
+}
+
+template <typename Fn>
+void run(const char *name, Fn &&write_all) {
+    int p[2];
+    if (::pipe(p) != 0) {
+        std::perror("pipe");
+        std::exit(1);
+    }
+    ::fcntl(p[1], F_SETPIPE_SZ, 1 << 20);
+    std::thread reader(drain_to_null, p[0]);
+    garda::BatchStats stats;
+    auto start = std::chrono::steady_clock::now();
+    bool ok = write_all(p[1], stats);
+    ::close(p[1]);
+    reader.join();
+    std::chrono::duration<double> dt = std::chrono::steady_clock::now() - start;
+    ::close(p[0]);
+    std::printf("%-10s %7.3f GB/s %10llu syscalls%s\n", name, stats.bytes / dt.count() / 1e9,
+                static_cast<unsigned long long>(stats.syscalls), ok ? "" : "  (write failed)");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::uint64_t lines = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 500000000;
+    std::printf("%llu lines, %.2f GB\n", static_cast<unsigned long long>(lines),
+                lines * garda::kGreeting.size() / 1e9);
+    run("writev", [&](int fd, garda::BatchStats &st) {
+        return garda::write_repeated(fd, garda::kGreeting, lines, &st);
+    });
+    run("vmsplice", [&](int fd, garda::BatchStats &st) {
+        return garda::write_repeated_zero_copy(fd, garda::kGreeting, lines, &st);
+    });
+    return 0;
+}
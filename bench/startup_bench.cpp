@@ -0,0 +1,106 @@
+// Spawns a program repeatedly and reports exec-to-exit latency percentiles,
+// page faults and peak RSS of the child.
+// Usage: startup_bench [-n runs] [program [args...]]
+// Without a program, the Tets_GARDA binary from the same build is used.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+namespace {
+
+struct Sample {
+    double usec;
+    long minflt;
+    long majflt;
+    long maxrss_kb;
+};
+
+double percentile(std::vector<double> &v, double p) {
+    std::size_t i = static_cast<std::size_t>(p * static_cast<double>(v.size() - 1) + 0.5);
+    std::nth_element(v.begin(), v.begin() + static_cast<std::ptrdiff_t>(i), v.end());
+    return v[i];
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    int runs = 2000;
+    int first = 1;
+    if (argc > 2 && !std::strcmp(argv[1], "-n")) {
+        runs = std::atoi(argv[2]);
+        first = 3;
+    }
+    std::vector<char *> child_argv;
+    static char default_binary[] = GARDA_DEFAULT_BINARY;
+    if (first < argc)
+        child_argv.assign(argv + first, argv + argc);
+    else
+        child_argv.push_back(default_binary);
+    child_argv.push_back(nullptr);
+    if (runs <= 0) {
+        std::fprintf(stderr, "runs must be positive\n");
+        return 2;
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+
+    std::vector<Sample> samples;
+    samples.reserve(static_cast<std::size_t>(runs));
+    for (int i = 0; i < runs; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        pid_t pid;
+        int err = posix_spawn(&pid, child_argv[0], &actions, nullptr, child_argv.data(), environ);
+        if (err) {
+            std::fprintf(stderr, "%s: %s\n", child_argv[0], std::strerror(err));
+            return 1;
+        }
+        int status;
+        struct rusage ru;
+        if (::wait4(pid, &status, 0, &ru) != pid) {
+            std::perror("wait4");
+            return 1;
+        }
+        std::chrono::duration<double, std::micro> dt = std::chrono::steady_clock::now() - start;
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            std::fprintf(stderr, "%s: child failed with status %d\n", child_argv[0], status);
+            return 1;
+        }
+        samples.push_back({dt.count(), ru.ru_minflt, ru.ru_majflt, ru.ru_maxrss});
+    }
+    posix_spawn_file_actions_destroy(&actions);
+
+    std::vector<double> lat;
+    double minflt = 0, majflt = 0, rss = 0;
+    long rss_max = 0;
+    for (const Sample &s : samples) {
+        lat.push_back(s.usec);
+        minflt += static_cast<double>(s.minflt);
+        majflt += static_cast<double>(s.majflt);
+        rss += static_cast<double>(s.maxrss_kb);
+        rss_max = std::max(rss_max, s.maxrss_kb);
+    }
+    double n = static_cast<double>(samples.size());
+    std::printf("program   %s\n", child_argv[0]);
+    std::printf("runs      %d\n", runs);
+    std::printf("p50       %.1f us\n", percentile(lat, 0.50));
+    std::printf("p99       %.1f us\n", percentile(lat, 0.99));
+    std::printf("p999      %.1f us\n", percentile(lat, 0.999));
+    std::printf("minflt    %.1f per run\n", minflt / n);
+    std::printf("majflt    %.2f per run\n", majflt / n);
+    std::printf("maxrss    %.0f KiB mean, %ld KiB max\n", rss / n, rss_max);
+    return 0;
+}
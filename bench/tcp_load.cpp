@@ -0,0 +1,95 @@
+// Connection-rate load generator for Tets_GARDA --serve-tcp: every client
+// thread repeatedly connects, reads the greeting until EOF and closes.
+// Usage: tcp_load PORT [clients] [seconds]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+    std::vector<float> usec;
+    unsigned long errors = 0;
+};
+
+bool one_connection(const sockaddr_in &addr) {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return false;
+    bool ok = ::connect(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) == 0;
+    char buf[512];
+    std::size_t got = 0;
+    for (ssize_t n; ok && (n = ::read(fd, buf, sizeof(buf))) != 0;) {
+        ok = n > 0;
+        got += ok ? static_cast<std::size_t>(n) : 0;
+    }
+    ::close(fd);
+    return ok && got > 0;
+}
+
+void client(const sockaddr_in &addr, Clock::time_point deadline, Result &r) {
+    r.usec.reserve(1 << 18);
+    while (Clock::now() < deadline) {
+        auto start = Clock::now();
+        if (!one_connection(addr)) {
+            ++r.errors;
+            continue;
+        }
+        std::chrono::duration<float, std::micro> dt = Clock::now() - start;
+        r.usec.push_back(dt.count());
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s PORT [clients] [seconds]\n", argv[0]);
+        return 2;
+    }
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<std::uint16_t>(std::atoi(argv[1])));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int clients = argc > 2 ? std::atoi(argv[2]) : 4;
+    double seconds = argc > 3 ? std::atof(argv[3]) : 3.0;
+    auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                       std::chrono::duration<double>(seconds));
+
+    std::vector<Result> results(static_cast<std::size_t>(clients));
+    std::vector<std::thread> threads;
+    for (Result &r : results)
+        threads.emplace_back(client, std::cref(addr), deadline, std::ref(r));
+    for (std::thread &t : threads)
+        t.join();
+
+    std::vector<float> all;
+    unsigned long errors = 0;
+    for (const Result &r : results) {
+        all.insert(all.end(), r.usec.begin(), r.usec.end());
+        errors += r.errors;
+    }
+    if (all.empty()) {
+        std::fprintf(stderr, "no successful connections (%lu errors)\n", errors);
+        return 1;
+    }
+    std::sort(all.begin(), all.end());
+    auto pct = [&](double p) { return all[static_cast<std::size_t>(p * (all.size() - 1))]; };
+    std::printf("clients   %d\n", clients);
+    std::printf("conns     %zu (%lu errors)\n", all.size(), errors);
+    std::printf("rate      %.0f conn/s\n", static_cast<double>(all.size()) / seconds);
+    std::printf("p50       %.1f us\n", pct(0.50));
+    std::printf("p99       %.1f us\n", pct(0.99));
+    return 0;
+}
@@ -0,0 +1,18 @@
+#!/bin/sh
+# Runs Tets_GARDA --serve-tcp with 1, 4 and all event loops and measures it
+# with tcp_load. Usage: bench/tcp_scaling.sh BUILD_DIR [port] [seconds]
+set -e
+build=${1:?usage: $0 BUILD_DIR [port] [seconds]}
+port=${2:-18080}
+seconds=${3:-5}
+cores=$(nproc)
+
+for threads in 1 4 "$cores"; do
+    "$build/Tets_GARDA" --serve-tcp "$port" --threads "$threads" &
+    server=$!
+    sleep 0.3
+    echo "== $threads event loop(s)"
+    "$build/tcp_load" "$port" $((threads * 2)) "$seconds" || true
+    kill "$server"
+    wait "$server" || true
+done
@@ -0,0 +1,115 @@
+// Benchmark for templated lines: ns per line and MB/s of the constant
+// greeting, template_filler() with a sequence number (and timestamp), and
+// the same numbered lines built with format_decimal(), snprintf() and
+// std::ostringstream. Every numbered variant is checked against the
+// template_filler() output.
+// Usage: template_bench [lines]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include "greeting.h"
+#include "int_format.h"
+#include "line_template.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::uint64_t kChunkLines = 64 * 1024;
+
+struct Result {
+    double ns_per_line;
+    double mbps;
+    std::uint64_t hash;
+};
+
+// Renders lines in chunks into a reused buffer, hashing every chunk.
+Result run(std::uint64_t lines, const garda::ChunkFiller &fill) {
+    std::string out;
+    std::uint64_t hash = 14695981039346656037ull;
+    std::uint64_t bytes = 0;
+    auto start = Clock::now();
+    for (std::uint64_t first = 0; first < lines; first += kChunkLines) {
+        out.clear();
+        fill(first, std::min(kChunkLines, lines - first), out);
+        bytes += out.size();
+        // Both ends of the chunk plus its length: cheap next to rendering,
+        // and enough to catch misnumbered or misplaced lines.
+        std::string_view v(out);
+        std::size_t tail = v.size() > 64 ? v.size() - 64 : 0;
+        for (unsigned char c : std::string(v.substr(0, 64)) + std::string(v.substr(tail)))
+            hash = (hash ^ c) * 1099511628211ull;
+        hash = (hash ^ out.size()) * 1099511628211ull;
+    }
+    std::chrono::duration<double> dt = Clock::now() - start;
+    return {dt.count() * 1e9 / static_cast<double>(lines), bytes / dt.count() / 1e6, hash};
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::uint64_t lines = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 50000000;
+    std::string_view text = garda::kGreeting.substr(0, garda::kGreeting.size() - 1);
+
+    garda::LineTemplate numbered;
+    numbered.sequence = true;
+    garda::LineTemplate stamped = numbered;
+    stamped.timestamp = true;
+
+    struct Case {
+        const char *name;
+        garda::ChunkFiller fill;
+        bool numbered;
+    } cases[] = {
+        {"constant", garda::repeat_filler(garda::kGreeting), false},
+        {"template #N", garda::template_filler(garda::kGreeting, numbered), true},
+        {"template #N ts", garda::template_filler(garda::kGreeting, stamped), false},
+        {"format_decimal", [text](std::uint64_t first, std::uint64_t n, std::string &out) {
+             char digits[garda::kMaxDecimalDigits];
+             for (std::uint64_t i = first + 1; i <= first + n; ++i) {
+                 out.append(text);
+                 out += " #";
+                 out.append(digits, garda::format_decimal(i, digits));
+                 out += '\n';
+             }
+         }, true},
+        {"snprintf", [text](std::uint64_t first, std::uint64_t n, std::string &out) {
+             char line[128];
+             for (std::uint64_t i = first + 1; i <= first + n; ++i) {
+                 int len = std::snprintf(line, sizeof(line), "%.*s #%llu\n",
+                                         static_cast<int>(text.size()), text.data(),
+                                         static_cast<unsigned long long>(i));
+                 out.append(line, static_cast<std::size_t>(len));
+             }
+         }, true},
+        {"ostringstream", [text](std::uint64_t first, std::uint64_t n, std::string &out) {
+             std::ostringstream os;
+             for (std::uint64_t i = first + 1; i <= first + n; ++i)
+                 os << text << " #" << i << '\n';
+             out += os.str();
+         }, true},
+    };
+
+    std::printf("%llu lines, chunks of %llu\n", static_cast<unsigned long long>(lines),
+                static_cast<unsigned long long>(kChunkLines));
+    double base = 0;
+    std::uint64_t reference = 0;
+    for (const Case &c : cases) {
+        Result r = run(lines, c.fill);
+        if (!base)
+            base = r.ns_per_line;
+        if (c.numbered && !reference)
+            reference = r.hash;
+        std::printf("%-16s %7.2f ns/line %8.0f MB/s %6.2fx constant  %s\n", c.name, r.ns_per_line,
+                    r.mbps, r.ns_per_line / base,
+                    !c.numbered ? "" : r.hash == reference ? "identical" : "MISMATCH");
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+// Load generator for Tets_GARDA --serve-unix: each client thread keeps one
+// connection and issues request/reply round trips for a fixed duration.
+// Usage: unix_load PATH [clients] [seconds]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "frame.h"
+#include "unix_service.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+    std::vector<float> usec;
+    bool failed = false;
+};
+
+// Reads one framed reply; returns false on EOF or error.
+bool read_reply(int fd, char *buf, std::size_t cap) {
+    std::size_t got = 0, need = garda::kFrameHeader;
+    while (got < need) {
+        ssize_t n = ::read(fd, buf + got, cap - got);
+        if (n <= 0)
+            return false;
+        got += static_cast<std::size_t>(n);
+        if (need == garda::kFrameHeader && got >= need)
+            need += garda::decode_frame_length(buf);
+    }
+    return true;
+}
+
+void client(const char *path, Clock::time_point deadline, Result &r) {
+    int fd = garda::connect_unix(path);
+    if (fd < 0) {
+        std::perror(path);
+        r.failed = true;
+        return;
+    }
+    r.usec.reserve(1 << 20);
+    char buf[4096];
+    while (Clock::now() < deadline) {
+        auto start = Clock::now();
+        if (::write(fd, "g", 1) != 1 || !read_reply(fd, buf, sizeof(buf))) {
+            r.failed = true;
+            break;
+        }
+        std::chrono::duration<float, std::micro> dt = Clock::now() - start;
+        r.usec.push_back(dt.count());
+    }
+    ::close(fd);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s PATH [clients] [seconds]\n", argv[0]);
+        return 2;
+    }
+    int clients = argc > 2 ? std::atoi(argv[2]) : 4;
+    double seconds = argc > 3 ? std::atof(argv[3]) : 3.0;
+    auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                       std::chrono::duration<double>(seconds));
+
+    std::vector<Result> results(static_cast<std::size_t>(clients));
+    std::vector<std::thread> threads;
+    for (Result &r : results)
+        threads.emplace_back(client, argv[1], deadline, std::ref(r));
+    for (std::thread &t : threads)
+        t.join();
+
+    std::vector<float> all;
+    for (const Result &r : results) {
+        if (r.failed)
+            std::fprintf(stderr, "warning: a client stopped early\n");
+        all.insert(all.end(), r.usec.begin(), r.usec.end());
+    }
+    if (all.empty())
+        return 1;
+    std::sort(all.begin(), all.end());
+    auto pct = [&](double p) { return all[static_cast<std::size_t>(p * (all.size() - 1))]; };
+    std::printf("clients   %d\n", clients);
+    std::printf("requests  %zu\n", all.size());
+    std::printf("rate      %.0f req/s\n", static_cast<double>(all.size()) / seconds);
+    std::printf("p50       %.1f us\n", pct(0.50));
+    std::printf("p99       %.1f us\n", pct(0.99));
+    return 0;
+}
@@ -0,0 +1,106 @@
+// Compares plain write(2) with UringSink at several queue depths on a
+// regular file, a pipe and /dev/null. Reports GB/s, SQEs/s, io_uring_enter
+// calls and CPU seconds per GB (including io-wq worker threads).
+// Usage: uring_bench [megabytes] [file]   (default: 512, ./uring_bench.out)
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "batch.h"
+#include "fd_sink.h"
+#include "greeting.h"
+#include "uring_sink.h"
+
+namespace {
+
+double cpu_seconds() {
+    struct rusage ru;
+    ::getrusage(RUSAGE_SELF, &ru);
+    return static_cast<double>(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) +
+           static_cast<double>(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+void drain(int fd) {
+    std::vector<char> buf(1 << 20);
+    while (::read(fd, buf.data(), buf.size()) > 0) {
+    }
+}
+
+// Opens the target, returning the write end; for pipes a reader thread is
+// started and must be joined by the caller after closing the fd.
+int open_target(const std::string &target, const std::string &file, std::thread &reader) {
+    if (target == "pipe") {
+        int p[2];
+        if (::pipe(p) != 0)
+            return -1;
+        ::fcntl(p[1], F_SETPIPE_SZ, 1 << 20);
+        reader = std::thread([fd = p[0]] {
+            drain(fd);
+            ::close(fd);
+        });
+        return p[1];
+    }
+    if (target == "null")
+        return ::open("/dev/null", O_WRONLY);
+    return ::open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+}
+
+void run(const std::string &target, const std::string &file, std::uint64_t lines, unsigned depth) {
+    std::thread reader;
+    int fd = open_target(target, file, reader);
+    if (fd < 0) {
+        std::perror(target.c_str());
+        std::exit(1);
+    }
+    double cpu0 = cpu_seconds();
+    auto start = std::chrono::steady_clock::now();
+    unsigned long long syscalls, sqes = 0;
+    bool ok;
+    const char *kind = "write(2)";
+    if (depth == 0) {
+        garda::FdSink sink(fd);
+        ok = garda::write_repeated(sink, garda::kGreeting, lines);
+        syscalls = sink.writes();
+    } else {
+        garda::UringConfig config;
+        config.queue_depth = depth;
+        garda::UringSink sink(fd, config);
+        if (!sink.uses_uring())
+            kind = "fallback";
+        ok = garda::write_repeated(sink, garda::kGreeting, lines, config.buffer_bytes);
+        syscalls = sink.writes();
+        sqes = sink.submissions();
+        if (sink.uses_uring())
+            kind = "io_uring";
+    }
+    std::chrono::duration<double> dt = std::chrono::steady_clock::now() - start;
+    double cpu = cpu_seconds() - cpu0;
+    ::close(fd);
+    if (reader.joinable())
+        reader.join();
+    double gb = static_cast<double>(lines * garda::kGreeting.size()) / 1e9;
+    std::printf("%-5s %-9s depth %3u %7.3f GB/s %11.0f sqe/s %8llu syscalls %6.3f cpu-s/GB%s\n",
+                target.c_str(), kind, depth, gb / dt.count(), sqes / dt.count(), syscalls,
+                cpu / gb, ok ? "" : "  (failed)");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::uint64_t mb = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 512;
+    std::string file = argc > 2 ? argv[2] : "uring_bench.out";
+    std::uint64_t lines = mb * 1000000 / garda::kGreeting.size();
+    for (const char *target : {"file", "pipe", "null"})
+        for (unsigned depth : {0u, 1u, 2u, 4u, 8u, 16u, 32u, 64u})
+            run(target, file, lines, depth);
+    ::unlink(file.c_str());
+    return 0;
+}
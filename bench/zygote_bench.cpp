@@ -0,0 +1,204 @@
+// Per-greeting process cost: a child forked by Tets_GARDA --zygote against
+// a fresh posix_spawn() of a program. Starts the zygote from the same
+// build, checks one request end to end through a pipe, and that a
+// --format '{pid}' line carries the child's pid rather than the zygote's,
+// then times
+// request-to-reply (fork, write, exit, reap) over one connection and
+// spawn-to-exit of the program, both writing one greeting to /dev/null.
+// Usage: zygote_bench [-n runs] [program [args...]]
+// Without a program, the Tets_GARDA binary is exec'd; pass the committed
+// hello binary to compare with it where it can run (aarch64, or qemu-user
+// via binfmt_misc).
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "greeting.h"
+#include "unix_service.h"
+#include "zygote.h"
+
+extern char **environ;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double percentile(std::vector<double> &v, double p) {
+    std::size_t i = static_cast<std::size_t>(p * static_cast<double>(v.size() - 1) + 0.5);
+    std::nth_element(v.begin(), v.begin() + static_cast<std::ptrdiff_t>(i), v.end());
+    return v[i];
+}
+
+// Starts binary --zygote path [extra...] and connects to it.
+bool start_zygote(char *binary, const std::string &path, std::vector<std::string> extra,
+                  pid_t &zygote, int &conn) {
+    extra.insert(extra.begin(), {"--zygote", path});
+    std::vector<char *> argv = {binary};
+    for (std::string &a : extra)
+        argv.push_back(&a[0]);
+    argv.push_back(nullptr);
+    if (int err = posix_spawn(&zygote, binary, nullptr, nullptr, argv.data(), environ)) {
+        std::fprintf(stderr, "%s: %s\n", binary, std::strerror(err));
+        return false;
+    }
+    conn = -1;
+    for (int i = 0; i < 2000 && conn < 0; ++i) {
+        conn = garda::connect_unix(path);
+        if (conn < 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (conn < 0) {
+        std::fprintf(stderr, "%s: zygote did not come up\n", path.c_str());
+        ::kill(zygote, SIGKILL);
+        ::waitpid(zygote, nullptr, 0);
+        return false;
+    }
+    return true;
+}
+
+void stop_zygote(pid_t zygote, int conn) {
+    ::close(conn);
+    ::kill(zygote, SIGTERM);
+    ::waitpid(zygote, nullptr, 0);
+}
+
+// Runs one request for count lines into a pipe and collects them; pid is
+// the child that wrote them.
+bool fetch(int conn, std::uint64_t count, std::string &out, int &pid, std::string &error) {
+    int pipe_fds[2];
+    if (::pipe(pipe_fds) != 0) {
+        error = std::string("pipe: ") + std::strerror(errno);
+        return false;
+    }
+    int status = 0;
+    bool ok = garda::zygote_spawn(conn, pipe_fds[1], count, pid, status, error);
+    ::close(pipe_fds[1]);
+    char buf[256];
+    for (ssize_t n; (n = ::read(pipe_fds[0], buf, sizeof buf)) > 0;)
+        out.append(buf, static_cast<std::size_t>(n));
+    ::close(pipe_fds[0]);
+    if (ok && (!WIFEXITED(status) || WEXITSTATUS(status) != 0)) {
+        error = "child failed";
+        ok = false;
+    }
+    return ok;
+}
+
+void report(const char *name, std::vector<double> &usec) {
+    std::printf("%-18s p50 %8.1f us  p99 %8.1f us  p999 %8.1f us\n", name, percentile(usec, 0.5),
+                percentile(usec, 0.99), percentile(usec, 0.999));
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    int runs = 2000;
+    int first = 1;
+    if (argc > 2 && !std::strcmp(argv[1], "-n")) {
+        runs = std::atoi(argv[2]);
+        first = 3;
+    }
+    if (runs <= 0) {
+        std::fprintf(stderr, "runs must be positive\n");
+        return 2;
+    }
+    static char binary[] = GARDA_DEFAULT_BINARY;
+    std::vector<char *> exec_argv;
+    if (first < argc)
+        exec_argv.assign(argv + first, argv + argc);
+    else
+        exec_argv.push_back(binary);
+    exec_argv.push_back(nullptr);
+
+    std::string base = "/tmp/garda-zygote." + std::to_string(::getpid());
+    std::string path = base + ".sock";
+    pid_t zygote;
+    int conn;
+    if (!start_zygote(binary, path, {"--lang", "en"}, zygote, conn))
+        return 1;
+
+    std::string error, out;
+    int pid = 0, status = 0;
+    bool ok = fetch(conn, 3, out, pid, error);
+    std::string expected;
+    for (int i = 0; i < 3; ++i)
+        expected += garda::kGreeting;
+    if (!ok || out != expected) {
+        std::fprintf(stderr, "zygote check failed: %s\n", ok ? "unexpected output" : error.c_str());
+        ok = false;
+    }
+
+    // Per-process fields are rendered in the child.
+    pid_t format_zygote;
+    int format_conn;
+    std::string format_path = base + ".format.sock";
+    if (ok && start_zygote(binary, format_path, {"--format", "{pid} {n}"}, format_zygote,
+                           format_conn)) {
+        for (int i = 0; ok && i < 2; ++i) {
+            out.clear();
+            ok = fetch(format_conn, 2, out, pid, error);
+            std::string want = std::to_string(pid) + " 1\n" + std::to_string(pid) + " 2\n";
+            if (!ok || out != want) {
+                std::fprintf(stderr, "--format {pid} check failed: %s\n",
+                             ok ? ("got \"" + out + "\" from child " + std::to_string(pid)).c_str()
+                                : error.c_str());
+                ok = false;
+            }
+        }
+        stop_zygote(format_zygote, format_conn);
+    } else if (ok) {
+        ok = false;
+    }
+
+    int devnull = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+    std::vector<double> forked, spawned;
+    forked.reserve(static_cast<std::size_t>(runs));
+    spawned.reserve(static_cast<std::size_t>(runs));
+    for (int i = 0; ok && i < runs; ++i) {
+        auto start = Clock::now();
+        ok = garda::zygote_spawn(conn, devnull, 1, pid, status, error) && status == 0;
+        forked.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    }
+    if (!ok)
+        std::fprintf(stderr, "zygote request failed: %s\n", error.c_str());
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    for (int i = 0; ok && i < runs; ++i) {
+        auto start = Clock::now();
+        pid_t child;
+        int err = posix_spawn(&child, exec_argv[0], &actions, nullptr, exec_argv.data(), environ);
+        if (err) {
+            std::fprintf(stderr, "%s: %s\n", exec_argv[0], std::strerror(err));
+            ok = false;
+            break;
+        }
+        ok = ::waitpid(child, &status, 0) == child && WIFEXITED(status) &&
+             WEXITSTATUS(status) == 0;
+        spawned.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    }
+    posix_spawn_file_actions_destroy(&actions);
+
+    ::close(devnull);
+    stop_zygote(zygote, conn);
+    if (!ok)
+        return 1;
+    std::printf("runs %d, exec'd program %s\n", runs, exec_argv[0]);
+    report("fork from zygote", forked);
+    report("fresh exec", spawned);
+    return 0;
+}
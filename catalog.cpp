@@ -0,0 +1,228 @@
+#include "catalog.h"
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "greeting.h"
+
+namespace garda {
+
+namespace {
+
+constexpr CatalogEntry kEntries[] = {
+    {"en", kGreeting},
+    {"af", "Hallo wêreld!\n"},
+    {"ar", "مرحبا بالعالم!\n"},
+    {"az", "Salam dünya!\n"},
+    {"be", "Прывітанне, свет!\n"},
+    {"bg", "Здравей, свят!\n"},
+    {"bn", "ওহে বিশ্ব!\n"},
+    {"bs", "Zdravo svijete!\n"},
+    {"ca", "Hola món!\n"},
+    {"cs", "Ahoj světe!\n"},
+    {"cy", "Helo byd!\n"},
+    {"da", "Hej verden!\n"},
+    {"de", "Hallo Welt!\n"},
+    {"el", "Γειά σου Κόσμε!\n"},
+    {"eo", "Saluton mondo!\n"},
+    {"es", "¡Hola, mundo!\n"},
+    {"et", "Tere maailm!\n"},
+    {"eu", "Kaixo mundua!\n"},
+    {"fa", "سلام دنیا!\n"},
+    {"fi", "Hei maailma!\n"},
+    {"fr", "Bonjour le monde !\n"},
+    {"ga", "Dia duit a dhomhain!\n"},
+    {"gl", "Ola mundo!\n"},
+    {"he", "שלום עולם!\n"},
+    {"hi", "नमस्ते दुनिया!\n"},
+    {"hr", "Pozdrav svijete!\n"},
+    {"hu", "Helló világ!\n"},
+    {"hy", "Բարև աշխարհ!\n"},
+    {"id", "Halo dunia!\n"},
+    {"is", "Halló heimur!\n"},
+    {"it", "Ciao mondo!\n"},
+    {"ja", "こんにちは世界！\n"},
+    {"ka", "გამარჯობა მსოფლიო!\n"},
+    {"kk", "Сәлем, әлем!\n"},
+    {"ko", "안녕하세요 세상!\n"},
+    {"la", "Salve munde!\n"},
+    {"lt", "Labas pasauli!\n"},
+    {"lv", "Sveika, pasaule!\n"},
+    {"mk", "Здраво свету!\n"},
+    {"mn", "Сайн уу, дэлхий!\n"},
+    {"mr", "नमस्कार जग!\n"},
+    {"ms", "Helo dunia!\n"},
+    {"mt", "Bongu dinja!\n"},
+    {"nb", "Hei verden!\n"},
+    {"nl", "Hallo wereld!\n"},
+    {"no", "Hei verden!\n"},
+    {"pl", "Witaj, świecie!\n"},
+    {"pt", "Olá, mundo!\n"},
+    {"ro", "Salut lume!\n"},
+    {"ru", "Привет, мир!\n"},
+    {"sk", "Ahoj svet!\n"},
+    {"sl", "Pozdravljen, svet!\n"},
+    {"sq", "Përshëndetje botë!\n"},
+    {"sr", "Здраво свете!\n"},
+    {"sv", "Hej världen!\n"},
+    {"sw", "Habari dunia!\n"},
+    {"ta", "வணக்கம் உலகம்!\n"},
+    {"te", "హలో ప్రపంచం!\n"},
+    {"th", "สวัสดีชาวโลก!\n"},
+    {"tl", "Kumusta mundo!\n"},
+    {"tr", "Merhaba dünya!\n"},
+    {"uk", "Привіт, світе!\n"},
+    {"ur", "ہیلو دنیا!\n"},
+    {"uz", "Salom dunyo!\n"},
+    {"vi", "Xin chào thế giới!\n"},
+    {"zh", "你好，世界！\n"},
+    {"zh_TW", "你好，世界！\n"},
+};
+
+constexpr std::size_t kEntryCount = sizeof(kEntries) / sizeof(kEntries[0]);
+constexpr std::size_t kSlots = 512;
+constexpr std::uint8_t kEmpty = 0xff;
+
+static_assert(kEntryCount < kEmpty, "slot indices are stored in a byte");
+static_assert((kSlots & (kSlots - 1)) == 0, "slot count must be a power of two");
+
+constexpr std::uint32_t hash(std::string_view s, std::uint32_t seed) {
+    std::uint32_t h = 2166136261u ^ (seed * 0x9e3779b9u);
+    for (char c : s) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 16777619u;
+    }
+    return h ^ (h >> 15);
+}
+
+struct PerfectHash {
+    std::uint32_t seed = 0;
+    std::array<std::uint8_t, kSlots> slots = {};
+};
+
+// Searches for the first seed that maps every language code to its own slot.
+constexpr PerfectHash build_perfect_hash() {
+    PerfectHash ph;
+    for (std::uint32_t seed = 1; seed < 100000; ++seed) {
+        for (auto &s : ph.slots)
+            s = kEmpty;
+        bool ok = true;
+        for (std::size_t i = 0; i < kEntryCount && ok; ++i) {
+            std::uint8_t &slot = ph.slots[hash(kEntries[i].lang, seed) & (kSlots - 1)];
+            ok = slot == kEmpty;
+            slot = static_cast<std::uint8_t>(i);
+        }
+        if (ok) {
+            ph.seed = seed;
+            return ph;
+        }
+    }
+    return PerfectHash();
+}
+
+constexpr PerfectHash kIndex = build_perfect_hash();
+
+static_assert(kIndex.seed != 0, "no collision-free seed found; grow kSlots");
+
+} // namespace
+
+const CatalogEntry *find_greeting(std::string_view lang) {
+    std::uint8_t i = kIndex.slots[hash(lang, kIndex.seed) & (kSlots - 1)];
+    if (i == kEmpty || kEntries[i].lang != lang)
+        return nullptr;
+    return &kEntries[i];
+}
+
+const CatalogEntry *greeting_for_locale(std::string_view locale) {
+    return resolve_locale(locale, find_greeting);
+}
+
+std::string_view locale_from_environment() {
+    for (const char *var : {"LC_ALL", "LC_MESSAGES", "LANG"}) {
+        const char *value = std::getenv(var);
+        if (value && *value)
+            return value;
+    }
+    return {};
+}
+
+const CatalogEntry &greeting_from_environment() {
+    std::string_view locale = locale_from_environment();
+    const CatalogEntry *e = locale.empty() ? nullptr : greeting_for_locale(locale);
+    return e ? *e : default_greeting();
+}
+
+const CatalogEntry &default_greeting() {
+    return kEntries[0];
+}
+
+std::size_t catalog_size() {
+    return kEntryCount;
+}
+
+const CatalogEntry &catalog_entry(std::size_t i) {
+    return kEntries[i];
+}
+
+bool CatalogFile::load(const std::string &path, std::string &error) {
+    std::FILE *f = std::fopen(path.c_str(), "rb");
+    if (!f) {
+        error = path + ": " + std::strerror(errno);
+        return false;
+    }
+    text_.clear();
+    char buf[65536];
+    for (std::size_t n; (n = std::fread(buf, 1, sizeof(buf), f)) > 0;)
+        text_.append(buf, n);
+    bool read_ok = !std::ferror(f);
+    std::fclose(f);
+    if (!read_ok) {
+        error = path + ": read error";
+        return false;
+    }
+    // Every greeting keeps its newline, so the last line needs one too.
+    if (!text_.empty() && text_.back() != '\n')
+        text_ += '\n';
+
+    entries_.clear();
+    index_.clear();
+    std::string_view rest = text_;
+    for (std::size_t line_no = 1; !rest.empty(); ++line_no) {
+        std::size_t nl = rest.find('\n');
+        std::string_view line = rest.substr(0, nl + 1);
+        rest.remove_prefix(nl + 1);
+        if (line.size() == 1 || line[0] == '#')
+            continue;
+        std::size_t tab = line.find('\t');
+        if (tab == 0 || tab == std::string_view::npos || tab + 2 == line.size()) {
+            error = path + ":" + std::to_string(line_no) + ": expected code<TAB>greeting";
+            return false;
+        }
+        CatalogEntry e = {line.substr(0, tab), line.substr(tab + 1)};
+        auto [it, inserted] = index_.emplace(e.lang, entries_.size());
+        if (inserted)
+            entries_.push_back(e);
+        else
+            entries_[it->second] = e;
+    }
+    return true;
+}
+
+const CatalogEntry *CatalogFile::find(std::string_view lang) const {
+    auto it = index_.find(lang);
+    return it != index_.end() ? &entries_[it->second] : find_greeting(lang);
+}
+
+std::vector<CatalogEntry> CatalogFile::merged() const {
+    std::vector<CatalogEntry> all(entries_);
+    for (std::size_t i = 0; i < kEntryCount; ++i)
+        if (!index_.count(kEntries[i].lang))
+            all.push_back(kEntries[i]);
+    return all;
+}
+
+} // namespace garda
@@ -0,0 +1,80 @@
+#ifndef GARDA_CATALOG_H
+#define GARDA_CATALOG_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace garda {
+
+struct CatalogEntry {
+    // Language code, optionally with a territory: "ru", "pt_BR".
+    std::string_view lang;
+    // Greeting line including the trailing newline.
+    std::string_view line;
+};
+
+// Looks up an exact language code in the compiled-in catalog. The catalog is
+// indexed by a perfect hash built at compile time, so this is one hash and
+// one string comparison. Returns nullptr for unknown codes.
+const CatalogEntry *find_greeting(std::string_view lang);
+
+// Resolves a POSIX locale name such as "ru_RU.UTF-8@euro" by trying
+// "ru_RU" and then "ru". Returns nullptr when neither is in the catalog.
+const CatalogEntry *greeting_for_locale(std::string_view locale);
+
+// The same resolution over any exact-code lookup; find returns something
+// that tests false for unknown codes.
+template <typename Find>
+auto resolve_locale(std::string_view locale, Find &&find) -> decltype(find(locale)) {
+    std::size_t cut = locale.find_first_of(".@");
+    std::string_view name = cut == std::string_view::npos ? locale : locale.substr(0, cut);
+    if (auto e = find(name))
+        return e;
+    std::size_t territory = name.find_first_of("_-");
+    if (territory == std::string_view::npos)
+        return decltype(find(locale))();
+    return find(name.substr(0, territory));
+}
+
+// The value of LC_ALL, LC_MESSAGES or LANG, whichever is set first; empty
+// if none is.
+std::string_view locale_from_environment();
+
+// Picks the greeting from LC_ALL, LC_MESSAGES or LANG (first one set, as
+// POSIX prescribes), falling back to English. Only getenv() is used: no
+// file I/O and no std::locale.
+const CatalogEntry &greeting_from_environment();
+
+const CatalogEntry &default_greeting();
+
+std::size_t catalog_size();
+const CatalogEntry &catalog_entry(std::size_t i);
+
+// Greetings read at start-up from a text file, one "code<TAB>greeting" per
+// line ('#' starts a comment line), on top of the compiled-in catalog:
+// file entries add languages or replace built-in ones. Unlike the
+// compiled-in table this is parsed and indexed on every start; a snapshot
+// (snapshot.h) stores the result instead.
+class CatalogFile {
+public:
+    bool load(const std::string &path, std::string &error);
+
+    // File entries first, then the compiled-in catalog.
+    const CatalogEntry *find(std::string_view lang) const;
+
+    // Every language once, file entries replacing built-in ones.
+    std::vector<CatalogEntry> merged() const;
+
+private:
+    // File contents; entries point into it.
+    std::string text_;
+    std::vector<CatalogEntry> entries_;
+    std::unordered_map<std::string_view, std::size_t> index_;
+};
+
+} // namespace garda
+
+#endif // GARDA_CATALOG_H
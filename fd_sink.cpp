@@ -0,0 +1,27 @@
+#include "fd_sink.h"
+
+#include <cerrno>
+
+#include <unistd.h>
+
+#include "stats.h"
+
+namespace garda {
+
+bool FdSink::write(const char *data, std::size_t n) {
+    while (n > 0) {
+        ++writes_;
+        ssize_t w = ::write(fd_, data, n);
+        if (w < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        note_write(static_cast<std::size_t>(w));
+        data += w;
+        n -= static_cast<std::size_t>(w);
+    }
+    return true;
+}
+
+} // namespace garda
@@ -0,0 +1,24 @@
+#ifndef GARDA_FD_SINK_H
+#define GARDA_FD_SINK_H
+
+#include "output.h"
+
+namespace garda {
+
+// Sink that writes straight to a file descriptor with write(2). It needs no
+// iostream machinery, so binaries built on it skip std::ios_base::Init.
+class FdSink : public Sink {
+public:
+    explicit FdSink(int fd) : fd_(fd) {}
+
+    bool write(const char *data, std::size_t n) override;
+
+    int fd() const { return fd_; }
+
+private:
+    int fd_;
+};
+
+} // namespace garda
+
+#endif // GARDA_FD_SINK_H
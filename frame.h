@@ -0,0 +1,32 @@
+#ifndef GARDA_FRAME_H
+#define GARDA_FRAME_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace garda {
+
+// Socket replies carry a 4-byte little-endian length followed by the payload.
+inline constexpr std::size_t kFrameHeader = 4;
+
+inline std::string encode_frame(std::string_view payload) {
+    std::uint32_t n = static_cast<std::uint32_t>(payload.size());
+    std::string out(kFrameHeader, '\0');
+    for (std::size_t i = 0; i < kFrameHeader; ++i)
+        out[i] = static_cast<char>((n >> (8 * i)) & 0xff);
+    out.append(payload);
+    return out;
+}
+
+inline std::uint32_t decode_frame_length(const char *header) {
+    std::uint32_t n = 0;
+    for (std::size_t i = 0; i < kFrameHeader; ++i)
+        n |= static_cast<std::uint32_t>(static_cast<unsigned char>(header[i])) << (8 * i);
+    return n;
+}
+
+} // namespace garda
+
+#endif // GARDA_FRAME_H
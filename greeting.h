@@ -0,0 +1,29 @@
+#ifndef GARDA_GREETING_H
+#define GARDA_GREETING_H
+
+#include <string_view>
+
+#include "message.h"
+
+namespace garda {
+
+inline constexpr FixedString kGreetingText("Hello world!\n");
+inline constexpr auto kFramedGreetingText = length_prefixed(kGreetingText);
+inline constexpr auto kHttpGreetingText = http_response(kGreetingText);
+
+// Wire forms of the greeting, fully rendered at compile time.
+inline constexpr std::string_view kGreeting = kGreetingText.view();
+inline constexpr std::string_view kFramedGreeting = kFramedGreetingText.view();
+inline constexpr std::string_view kHttpGreeting = kHttpGreetingText.view();
+
+static_assert(kGreeting == "Hello world!\n");
+static_assert(kFramedGreeting == std::string_view("\x0d\0\0\0Hello world!\n", 17));
+static_assert(kHttpGreeting == "HTTP/1.1 200 OK\r\n"
+                               "Content-Type: text/plain; charset=utf-8\r\n"
+                               "Content-Length: 13\r\n"
+                               "\r\n"
+                               "Hello world!\n");
+
+} // namespace garda
+
+#endif // GARDA_GREETING_H
@@ -0,0 +1,110 @@
+#include "http.h"
+
+#include <cstring>
+
+namespace garda {
+
+namespace {
+
+constexpr std::string_view kHeadEnd = "\r\n\r\n";
+
+char lower(char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+bool iequals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size())
+        return false;
+    for (std::size_t i = 0; i < a.size(); ++i)
+        if (lower(a[i]) != lower(b[i]))
+            return false;
+    return true;
+}
+
+bool contains_token(std::string_view value, std::string_view token) {
+    for (std::size_t i = 0; i + token.size() <= value.size(); ++i)
+        if (iequals(value.substr(i, token.size()), token))
+            return true;
+    return false;
+}
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t'))
+        s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t'))
+        s.remove_suffix(1);
+    return s;
+}
+
+} // namespace
+
+std::string render_http_response(std::string_view body, std::string_view content_type) {
+    std::string out = "HTTP/1.1 200 OK\r\nContent-Type: ";
+    out.append(content_type);
+    out += "\r\nContent-Length: ";
+    out += std::to_string(body.size());
+    out += "\r\n\r\n";
+    out.append(body);
+    return out;
+}
+
+HttpParse parse_http_request(const char *data, std::size_t n, HttpRequest &req) {
+    req.length = 0;
+    std::string_view buf(data, n);
+    std::size_t head_end = buf.find(kHeadEnd);
+    if (head_end == std::string_view::npos)
+        return HttpParse::Incomplete;
+    std::string_view head = buf.substr(0, head_end);
+
+    std::size_t eol = head.find("\r\n");
+    std::string_view request_line = head.substr(0, eol);
+    std::size_t version_at = request_line.rfind(' ');
+    if (version_at == std::string_view::npos || request_line.find(' ') == version_at)
+        return HttpParse::Invalid;
+    std::string_view version = request_line.substr(version_at + 1);
+    if (version != "HTTP/1.1" && version != "HTTP/1.0")
+        return HttpParse::Invalid;
+    std::size_t method_end = request_line.find(' ');
+    if (method_end == 0)
+        return HttpParse::Invalid;
+    std::string_view method = request_line.substr(0, method_end);
+    req.method = method == "GET"    ? HttpMethod::Get
+                 : method == "HEAD" ? HttpMethod::Head
+                                    : HttpMethod::Other;
+
+    bool keep_alive = version == "HTTP/1.1";
+    std::size_t body = 0;
+    while (eol != std::string_view::npos) {
+        std::size_t start = eol + 2;
+        eol = head.find("\r\n", start);
+        std::string_view line = head.substr(start, eol == std::string_view::npos ? eol : eol - start);
+        std::size_t colon = line.find(':');
+        if (colon == std::string_view::npos)
+            return HttpParse::Invalid;
+        std::string_view name = line.substr(0, colon);
+        std::string_view value = trim(line.substr(colon + 1));
+        if (iequals(name, "connection")) {
+            if (contains_token(value, "close"))
+                keep_alive = false;
+            else if (contains_token(value, "keep-alive"))
+                keep_alive = true;
+        } else if (iequals(name, "transfer-encoding")) {
+            return HttpParse::Invalid;
+        } else if (iequals(name, "content-length")) {
+            if (value.empty())
+                return HttpParse::Invalid;
+            body = 0;
+            for (char c : value) {
+                if (c < '0' || c > '9' || body > (std::size_t(1) << 40))
+                    return HttpParse::Invalid;
+                body = body * 10 + static_cast<std::size_t>(c - '0');
+            }
+        }
+    }
+
+    req.length = head_end + kHeadEnd.size() + body;
+    req.close = !keep_alive;
+    return req.length > n ? HttpParse::Incomplete : HttpParse::Complete;
+}
+
+} // namespace garda
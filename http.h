@@ -0,0 +1,39 @@
+#ifndef GARDA_HTTP_H
+#define GARDA_HTTP_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace garda {
+
+// Full HTTP/1.1 200 response carrying body as text/plain. Rendered once at
+// startup; the server only ever copies these bytes.
+std::string render_http_response(std::string_view body,
+                                 std::string_view content_type = "text/plain; charset=utf-8");
+
+enum class HttpMethod { Get, Head, Other };
+
+struct HttpRequest {
+    HttpMethod method = HttpMethod::Get;
+    // Bytes occupied by the request line, headers and body.
+    std::size_t length = 0;
+    // The client asked for the connection to be closed after the reply.
+    bool close = false;
+};
+
+enum class HttpParse { Complete, Incomplete, Invalid };
+
+// Looks for one complete request at the start of [data, data + n). Only the
+// framing is checked: the request line, Connection and Content-Length, which
+// must be a decimal number. Once the head is in, req is filled even while
+// the body is Incomplete, so a caller can tell how much is still to come;
+// before that req.length is 0.
+// Requests with Transfer-Encoding are Invalid: a chunked body cannot be
+// skipped without decoding it, and guessing would desynchronize pipelined
+// requests after it.
+HttpParse parse_http_request(const char *data, std::size_t n, HttpRequest &req);
+
+} // namespace garda
+
+#endif // GARDA_HTTP_H
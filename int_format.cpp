@@ -0,0 +1,58 @@
+#include "int_format.h"
+
+#include <cstring>
+
+namespace garda {
+
+namespace {
+
+struct DigitPairs {
+    char text[200];
+
+    constexpr DigitPairs() : text() {
+        for (int i = 0; i < 100; ++i) {
+            text[2 * i] = static_cast<char>('0' + i / 10);
+            text[2 * i + 1] = static_cast<char>('0' + i % 10);
+        }
+    }
+};
+
+constexpr DigitPairs kPairs;
+
+std::size_t digit_count(std::uint64_t v) {
+    std::size_t n = 1;
+    for (; v >= 10000; v /= 10000)
+        n += 4;
+    if (v >= 1000)
+        return n + 3;
+    if (v >= 100)
+        return n + 2;
+    return v >= 10 ? n + 1 : n;
+}
+
+} // namespace
+
+std::size_t format_decimal(std::uint64_t v, char *out) {
+    std::size_t len = digit_count(v);
+    char *p = out + len;
+    while (v >= 100) {
+        p -= 2;
+        std::memcpy(p, kPairs.text + 2 * (v % 100), 2);
+        v /= 100;
+    }
+    if (v >= 10)
+        std::memcpy(p - 2, kPairs.text + 2 * v, 2);
+    else
+        p[-1] = static_cast<char>('0' + v);
+    return len;
+}
+
+std::size_t format_timestamp(std::uint64_t seconds, unsigned millis, char *out) {
+    std::size_t len = format_decimal(seconds, out);
+    out[len] = '.';
+    out[len + 1] = static_cast<char>('0' + millis / 100);
+    std::memcpy(out + len + 2, kPairs.text + 2 * (millis % 100), 2);
+    return len + 4;
+}
+
+} // namespace garda
@@ -0,0 +1,39 @@
+#ifndef GARDA_INT_FORMAT_H
+#define GARDA_INT_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace garda {
+
+constexpr std::size_t kMaxDecimalDigits = 20;
+// "seconds.mmm" for any 64-bit second count.
+constexpr std::size_t kMaxTimestampChars = kMaxDecimalDigits + 4;
+
+// Writes v in decimal to out (no terminator) and returns the length. Digits
+// are produced two at a time from a 200-byte pair table; no locale, no
+// allocation. out must have room for kMaxDecimalDigits bytes.
+std::size_t format_decimal(std::uint64_t v, char *out);
+
+// Writes "seconds.mmm"; returns the length.
+std::size_t format_timestamp(std::uint64_t seconds, unsigned millis, char *out);
+
+// Adds one to the decimal number in [first, last) in place, rewriting only
+// the digits that change (one byte nine times out of ten). Returns false
+// when every digit was a nine: the range now holds zeros and the caller
+// must prepend a '1'.
+inline bool increment_decimal(char *first, char *last) {
+    while (last != first) {
+        --last;
+        if (*last != '9') {
+            ++*last;
+            return true;
+        }
+        *last = '0';
+    }
+    return false;
+}
+
+} // namespace garda
+
+#endif // GARDA_INT_FORMAT_H
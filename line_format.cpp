@@ -0,0 +1,108 @@
+#include "line_format.h"
+
+#include <time.h>
+#include <unistd.h>
+
+namespace garda {
+
+namespace {
+
+constexpr std::uint64_t kClockLines = 100;
+
+std::string host_name() {
+    char name[256];
+    if (::gethostname(name, sizeof(name)) != 0)
+        return "localhost";
+    name[sizeof(name) - 1] = '\0';
+    return name;
+}
+
+} // namespace
+
+bool LineFormat::compile(std::string_view text, std::string_view greeting, std::string &error) {
+    if (!greeting.empty() && greeting.back() == '\n')
+        greeting.remove_suffix(1);
+    pool_.clear();
+    code_.clear();
+    uses_time_ = false;
+    std::string literal;
+    auto flush = [&] {
+        if (literal.empty())
+            return;
+        code_.push_back({Op::Literal, static_cast<std::uint32_t>(pool_.size()),
+                         static_cast<std::uint32_t>(literal.size())});
+        pool_ += literal;
+        literal.clear();
+    };
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        char c = text[i];
+        if ((c == '{' || c == '}') && i + 1 < text.size() && text[i + 1] == c) {
+            literal += c;
+            ++i;
+            continue;
+        }
+        if (c == '}') {
+            error = "--format: unmatched '}' at offset " + std::to_string(i);
+            return false;
+        }
+        if (c != '{') {
+            literal += c;
+            continue;
+        }
+        std::size_t close = text.find('}', i);
+        if (close == std::string_view::npos) {
+            error = "--format: unterminated '{' at offset " + std::to_string(i);
+            return false;
+        }
+        std::string_view field = text.substr(i + 1, close - i - 1);
+        if (field == "greeting") {
+            literal += greeting;
+        } else if (field == "host") {
+            literal += host_name();
+        } else if (field == "n" || field == "time" || field == "pid") {
+            flush();
+            Op op = field == "n" ? Op::Number : field == "time" ? Op::Time : Op::Pid;
+            code_.push_back({op, 0, 0});
+            uses_time_ = uses_time_ || field == "time";
+        } else {
+            error = "--format: unknown field {" + std::string(field) +
+                    "}; expected greeting, host, pid, n or time";
+            return false;
+        }
+        i = close;
+    }
+    literal += '\n';
+    flush();
+
+    max_line_ = 0;
+    for (const Instruction &i : code_)
+        max_line_ += i.op == Op::Literal ? i.size
+                     : i.op == Op::Time  ? kMaxTimestampChars
+                                         : kMaxDecimalDigits;
+    return true;
+}
+
+ChunkFiller format_filler(const LineFormat &format) {
+    return [format](std::uint64_t first, std::uint64_t n, std::string &out) {
+        char stamp[kMaxTimestampChars];
+        std::size_t stamp_len = 0;
+        char pid[kMaxDecimalDigits];
+        std::size_t pid_len = format_decimal(static_cast<std::uint64_t>(::getpid()), pid);
+        std::size_t at = out.size();
+        out.resize(at + static_cast<std::size_t>(n) * format.max_line());
+        char *p = &out[at];
+        for (std::uint64_t i = 0; i < n; ++i) {
+            if (format.uses_time() && i % kClockLines == 0) {
+                timespec ts;
+                ::clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+                stamp_len = format_timestamp(static_cast<std::uint64_t>(ts.tv_sec),
+                                             static_cast<unsigned>(ts.tv_nsec / 1000000), stamp);
+            }
+            p = format.render(p, first + i + 1, std::string_view(stamp, stamp_len),
+                              std::string_view(pid, pid_len));
+        }
+        out.resize(static_cast<std::size_t>(p - out.data()));
+    };
+}
+
+} // namespace garda
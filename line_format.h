@@ -0,0 +1,89 @@
+#ifndef GARDA_LINE_FORMAT_H
+#define GARDA_LINE_FORMAT_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "int_format.h"
+#include "parallel_gen.h"
+
+namespace garda {
+
+// Line layout given at run time (--format), e.g.
+// "{greeting} from {host}[{pid}] #{n} {time}". Fields:
+//   {greeting}  the greeting for the configured language
+//   {host}      the host name
+//   {pid}       the id of the process rendering the line
+//   {n}         the line number, counting from 1 across the whole output
+//   {time}      seconds.mmm of CLOCK_REALTIME_COARSE
+// "{{" and "}}" stand for single braces; every line ends with '\n'.
+//
+// compile() parses the text once into a short instruction stream over a
+// literal pool. The greeting and host are substituted right there and
+// merged with the literals around them, so rendering a line only copies
+// literal spans and writes the number, the time and the pid. The pid is
+// left to render time because a --zygote child renders lines with a format
+// compiled in its parent. render() writes into the caller's buffer and
+// never allocates.
+class LineFormat {
+public:
+    enum class Op : std::uint8_t { Literal, Number, Time, Pid };
+
+    struct Instruction {
+        Op op;
+        // Span of the literal pool, for Op::Literal.
+        std::uint32_t offset;
+        std::uint32_t size;
+    };
+
+    bool compile(std::string_view text, std::string_view greeting, std::string &error);
+
+    // Upper bound on the length of a rendered line.
+    std::size_t max_line() const { return max_line_; }
+    bool uses_time() const { return uses_time_; }
+    const std::vector<Instruction> &code() const { return code_; }
+
+    // Renders line number to out, which has room for max_line() bytes;
+    // stamp and pid are the {time} and {pid} texts. Returns the end of the
+    // line.
+    char *render(char *out, std::uint64_t number, std::string_view stamp,
+                 std::string_view pid) const {
+        for (const Instruction &i : code_) {
+            switch (i.op) {
+            case Op::Literal:
+                std::memcpy(out, pool_.data() + i.offset, i.size);
+                out += i.size;
+                break;
+            case Op::Number:
+                out += format_decimal(number, out);
+                break;
+            case Op::Time:
+                std::memcpy(out, stamp.data(), stamp.size());
+                out += stamp.size();
+                break;
+            case Op::Pid:
+                std::memcpy(out, pid.data(), pid.size());
+                out += pid.size();
+                break;
+            }
+        }
+        return out;
+    }
+
+private:
+    std::string pool_;
+    std::vector<Instruction> code_;
+    std::size_t max_line_ = 0;
+    bool uses_time_ = false;
+};
+
+// Filler that renders lines with format, reading the coarse clock once per
+// 100 lines when it has a {time} field and the pid once per chunk.
+ChunkFiller format_filler(const LineFormat &format);
+
+} // namespace garda
+
+#endif // GARDA_LINE_FORMAT_H
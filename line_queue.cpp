@@ -0,0 +1,167 @@
+#include "line_queue.h"
+
+#include <cstring>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace garda {
+
+namespace {
+
+// Empty polls of the queue before the writer goes to sleep.
+constexpr int kIdleSpins = 64;
+
+void futex_wait(std::atomic<int> &word, int expected) {
+    ::syscall(SYS_futex, reinterpret_cast<int *>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr,
+              nullptr, 0);
+}
+
+void futex_wake(std::atomic<int> &word) {
+    ::syscall(SYS_futex, reinterpret_cast<int *>(&word), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr,
+              0);
+}
+
+} // namespace
+
+LineQueue::LineQueue(std::size_t slots) {
+    std::size_t cap = 2;
+    while (cap < slots)
+        cap *= 2;
+    mask_ = cap - 1;
+    slots_.reset(new Slot[cap]);
+    data_.reset(new char[cap * kSlotBytes]);
+    for (std::size_t i = 0; i < cap; ++i)
+        slots_[i].seq.store(i, std::memory_order_relaxed);
+}
+
+bool LineQueue::try_push(std::string_view line) {
+    const std::uint64_t cap = mask_ + 1;
+    std::uint64_t k = line.empty() ? 1 : (line.size() + kSlotBytes - 1) / kSlotBytes;
+    if (k > cap / 2)
+        return false;
+
+    std::uint64_t pos = tail_.load(std::memory_order_relaxed);
+    std::uint64_t pad;
+    for (;;) {
+        std::uint64_t idx = pos & mask_;
+        pad = idx + k > cap ? cap - idx : 0;
+        std::uint64_t last = pos + pad + k - 1;
+        std::uint64_t seq = slots_[last & mask_].seq.load(std::memory_order_acquire);
+        auto diff = static_cast<std::int64_t>(seq - last);
+        if (diff == 0) {
+            if (tail_.compare_exchange_weak(pos, pos + pad + k, std::memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            return false; // the consumer has not freed the slots yet
+        } else {
+            pos = tail_.load(std::memory_order_relaxed);
+        }
+    }
+
+    if (pad) {
+        Slot &skip = slots_[pos & mask_];
+        skip.len = 0;
+        skip.span = static_cast<std::uint32_t>(pad);
+        skip.seq.store(pos + 1, std::memory_order_release);
+        pos += pad;
+    }
+    std::memcpy(data_.get() + (pos & mask_) * kSlotBytes, line.data(), line.size());
+    Slot &s = slots_[pos & mask_];
+    s.len = static_cast<std::uint32_t>(line.size());
+    s.span = static_cast<std::uint32_t>(k);
+    s.seq.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+std::size_t LineQueue::drain(std::string &out, std::size_t max_bytes) {
+    const std::uint64_t cap = mask_ + 1;
+    std::size_t lines = 0;
+    while (out.size() < max_bytes) {
+        const Slot &s = slots_[head_ & mask_];
+        if (s.seq.load(std::memory_order_acquire) != head_ + 1)
+            break;
+        if (s.len) {
+            out.append(data_.get() + (head_ & mask_) * kSlotBytes, s.len);
+            ++lines;
+        }
+        std::uint32_t span = s.span;
+        for (std::uint32_t j = 0; j < span; ++j)
+            slots_[(head_ + j) & mask_].seq.store(head_ + j + cap, std::memory_order_release);
+        head_ += span;
+    }
+    return lines;
+}
+
+bool LineQueue::empty() const {
+    return slots_[head_ & mask_].seq.load(std::memory_order_acquire) != head_ + 1;
+}
+
+QueuedWriter::QueuedWriter(Sink &sink, std::size_t slots, std::size_t batch_bytes)
+    : sink_(sink), queue_(slots), batch_bytes_(batch_bytes ? batch_bytes : 1) {
+    thread_ = std::thread(&QueuedWriter::run, this);
+}
+
+QueuedWriter::~QueuedWriter() {
+    close();
+}
+
+bool QueuedWriter::push(std::string_view line) {
+    while (!queue_.try_push(line)) {
+        if (line.size() > queue_.max_line())
+            return false;
+        std::this_thread::yield();
+    }
+    // Pairs with the fence in run(): either the writer sees this line before
+    // sleeping or this thread sees it asleep.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping_.load(std::memory_order_relaxed))
+        wake();
+    return true;
+}
+
+bool QueuedWriter::close() {
+    if (!closed_) {
+        closed_ = true;
+        stop_.store(true, std::memory_order_seq_cst);
+        wake();
+        thread_.join();
+    }
+    return ok_;
+}
+
+void QueuedWriter::wake() {
+    sleeping_.store(0, std::memory_order_relaxed);
+    futex_wake(sleeping_);
+}
+
+void QueuedWriter::run() {
+    std::string batch;
+    batch.reserve(batch_bytes_ + queue_.max_line());
+    int idle = 0;
+    for (;;) {
+        batch.clear();
+        queue_.drain(batch, batch_bytes_);
+        if (!batch.empty()) {
+            ok_ = ok_ && sink_.write(batch.data(), batch.size());
+            idle = 0;
+            continue;
+        }
+        if (stop_.load(std::memory_order_acquire) && queue_.empty())
+            break;
+        if (++idle < kIdleSpins) {
+            std::this_thread::yield();
+            continue;
+        }
+        sleeping_.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (queue_.empty() && !stop_.load(std::memory_order_relaxed))
+            futex_wait(sleeping_, 1);
+        sleeping_.store(0, std::memory_order_relaxed);
+        idle = 0;
+    }
+    ok_ = sink_.sync() && ok_;
+}
+
+} // namespace garda
@@ -0,0 +1,102 @@
+#ifndef GARDA_LINE_QUEUE_H
+#define GARDA_LINE_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "output.h"
+
+namespace garda {
+
+// Bounded lock-free multi-producer single-consumer queue of byte strings
+// (preformatted lines). The ring is an array of kSlotBytes-byte slots with
+// a sequence number each, in the style of Vyukov's bounded queue: a
+// producer claims as many consecutive slots as its line needs with one CAS
+// on the tail, copies the bytes in and publishes the first slot's
+// sequence. Slot data is contiguous, so a line is never split except by
+// the end of the ring, which is skipped over instead. The consumer
+// releases slots strictly in order, which is why a producer only has to
+// check the last slot it claims.
+class LineQueue {
+public:
+    static constexpr std::size_t kSlotBytes = 64;
+
+    // slots is rounded up to a power of two (at least 2).
+    explicit LineQueue(std::size_t slots = 16384);
+
+    LineQueue(const LineQueue &) = delete;
+    LineQueue &operator=(const LineQueue &) = delete;
+
+    // Copies line into the queue. Returns false if there is no room right
+    // now, or ever (lines longer than max_line()).
+    bool try_push(std::string_view line);
+
+    // Appends whole lines to out until it holds at least max_bytes or the
+    // queue is empty; returns the number of lines taken. Consumer only.
+    std::size_t drain(std::string &out, std::size_t max_bytes);
+
+    bool empty() const;
+    std::size_t max_line() const { return (mask_ + 1) / 2 * kSlotBytes; }
+
+private:
+    struct Slot {
+        std::atomic<std::uint64_t> seq;
+        // Bytes of the line starting here and slots it occupies; a span
+        // with len 0 is the skipped end of the ring.
+        std::uint32_t len;
+        std::uint32_t span;
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    std::unique_ptr<char[]> data_;
+    std::uint64_t mask_;
+    alignas(64) std::atomic<std::uint64_t> tail_{0};
+    alignas(64) std::uint64_t head_ = 0;
+};
+
+// Owns a LineQueue and a writer thread that drains it into a Sink in
+// batches, so producer threads never block on the sink or on each other.
+// Lines from different producers interleave whole; each producer's lines
+// stay in its own order.
+class QueuedWriter {
+public:
+    explicit QueuedWriter(Sink &sink, std::size_t slots = 16384,
+                          std::size_t batch_bytes = 256 * 1024);
+    // Drains everything pushed so far, then stops the writer.
+    ~QueuedWriter();
+
+    QueuedWriter(const QueuedWriter &) = delete;
+    QueuedWriter &operator=(const QueuedWriter &) = delete;
+
+    // Enqueues line, spinning and yielding while the queue is full. Wakes
+    // the writer (one futex call) only if it went to sleep. Returns false
+    // for a line longer than the queue can hold.
+    bool push(std::string_view line);
+
+    // Waits until the writer has handed every pushed line to the sink and
+    // the sink has synced; returns false if the sink failed.
+    bool close();
+
+private:
+    void run();
+    void wake();
+
+    Sink &sink_;
+    LineQueue queue_;
+    std::size_t batch_bytes_;
+    bool ok_ = true;
+    bool closed_ = false;
+    // Futex word: 1 while the writer sleeps waiting for lines.
+    alignas(64) std::atomic<int> sleeping_{0};
+    std::atomic<bool> stop_{false};
+    std::thread thread_;
+};
+
+} // namespace garda
+
+#endif // GARDA_LINE_QUEUE_H
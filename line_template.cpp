@@ -0,0 +1,185 @@
+#include "line_template.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <time.h>
+
+#include "arena.h"
+#include "int_format.h"
+
+namespace garda {
+
+namespace {
+
+// Lines are emitted in runs of this many, whose numbers differ only in the
+// last two digits. The clock is read once per run: CLOCK_REALTIME_COARSE
+// ticks every few milliseconds, far slower than a run takes to render.
+constexpr std::uint64_t kRunLines = 100;
+
+// One rendered line: text " #digits" " stamp" "\n", patched in place. Its
+// buffer lives in the calling thread's arena.
+class LineImage {
+public:
+    LineImage(std::string_view text, const LineTemplate &tmpl, std::uint64_t number)
+        : tmpl_(tmpl), buf_(ArenaAllocator<char>(thread_arena())) {
+        buf_.reserve(text.size() + kMaxDecimalDigits + kMaxTimestampChars + 4);
+        buf_.assign(text.data(), text.size());
+        if (tmpl_.sequence) {
+            buf_ += " #";
+            digits_begin_ = buf_.size();
+            char digits[kMaxDecimalDigits];
+            buf_.append(digits, format_decimal(number, digits));
+        }
+        digits_end_ = buf_.size();
+        if (tmpl_.timestamp)
+            buf_ += ' ';
+        stamp_begin_ = buf_.size();
+        buf_ += '\n';
+    }
+
+    const char *data() const { return buf_.data(); }
+    std::size_t size() const { return buf_.size(); }
+    std::size_t digits_begin() const { return digits_begin_; }
+    std::size_t digits_end() const { return digits_end_; }
+
+    void next() {
+        if (tmpl_.sequence && !increment_decimal(&buf_[digits_begin_], &buf_[digits_end_])) {
+            buf_.insert(digits_begin_, 1, '1');
+            ++digits_end_;
+            ++stamp_begin_;
+        }
+    }
+
+    // Re-renders the timestamp if the coarse clock has moved; returns
+    // whether it did.
+    bool stamp() {
+        timespec ts;
+        ::clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+        auto seconds = static_cast<std::uint64_t>(ts.tv_sec);
+        auto millis = static_cast<unsigned>(ts.tv_nsec / 1000000);
+        if (seconds == seconds_ && millis == millis_)
+            return false;
+        seconds_ = seconds;
+        millis_ = millis;
+        char text[kMaxTimestampChars];
+        std::size_t len = format_timestamp(seconds, millis, text);
+        buf_.resize(stamp_begin_);
+        buf_.append(text, len);
+        buf_ += '\n';
+        return true;
+    }
+
+private:
+    LineTemplate tmpl_;
+    ArenaString buf_;
+    std::size_t digits_begin_ = 0;
+    std::size_t digits_end_ = 0;
+    std::size_t stamp_begin_ = 0;
+    std::uint64_t seconds_ = ~std::uint64_t(0);
+    unsigned millis_ = 0;
+};
+
+// Appends img n times (n <= kRunLines), advancing it after each line.
+void emit_lines(LineImage &img, std::uint64_t n, std::string &out) {
+    // The number gains a digit at most twice in kRunLines lines.
+    std::size_t at = out.size();
+    out.resize(at + static_cast<std::size_t>(n) * (img.size() + 2));
+    char *p = &out[at];
+    for (std::uint64_t i = 0; i < n; ++i) {
+        std::memcpy(p, img.data(), img.size());
+        p += img.size();
+        img.next();
+    }
+    out.resize(static_cast<std::size_t>(p - out.data()));
+}
+
+// Emits lines from number on, up to the last whole run of kRunLines. A
+// run is rendered once; the next run is the same bytes with the digits
+// above the last two bumped, so it costs one increment_decimal() and the
+// changed digits copied into the other lines (usually one byte each). This
+// keeps the per-line work off the byte-wise digit stores, which a wide
+// memcpy of the line would otherwise have to wait on. The run is rendered
+// again when the number gains a digit or the timestamp moves. number and n
+// are advanced past the lines emitted.
+void emit_runs(std::string_view text, const LineTemplate &tmpl, std::uint64_t &number,
+               std::uint64_t &n, std::string &out) {
+    ArenaString run{ArenaAllocator<char>(thread_arena())};
+    while (n >= kRunLines) {
+        LineImage start(text, tmpl, number);
+        if (tmpl.timestamp)
+            start.stamp();
+        std::size_t len = start.size();
+        std::size_t hi_begin = start.digits_begin();
+        std::size_t hi_end = tmpl.sequence ? start.digits_end() - 2 : hi_begin;
+        run.clear();
+        run.reserve(kRunLines * len);
+        for (std::uint64_t i = 0; i < kRunLines; ++i) {
+            run.append(start.data(), len);
+            start.next();
+        }
+        for (;;) {
+            out.append(run.data(), run.size());
+            number += kRunLines;
+            n -= kRunLines;
+            if (n < kRunLines || (tmpl.timestamp && start.stamp()))
+                break;
+            if (hi_begin == hi_end)
+                continue;
+            char *line = &run[0];
+            if (!increment_decimal(line + hi_begin, line + hi_end))
+                break; // one digit longer
+            // The bumped digit and the zeros after it.
+            std::size_t from = hi_end - 1;
+            while (line[from] == '0')
+                --from;
+            std::size_t changed = hi_end - from;
+            for (std::uint64_t i = 1; i < kRunLines; ++i) {
+                char *other = line + i * len + from;
+                if (changed == 1)
+                    *other = line[from];
+                else
+                    std::memcpy(other, line + from, changed);
+            }
+        }
+    }
+}
+
+} // namespace
+
+ChunkFiller template_filler(std::string_view line, const LineTemplate &tmpl) {
+    if (!line.empty() && line.back() == '\n')
+        line.remove_suffix(1);
+    return [line, tmpl](std::uint64_t first, std::uint64_t n, std::string &out) {
+        if (n == 0)
+            return;
+        // Everything rendered for the chunk comes from the thread's arena and
+        // is released in one go; out is the caller's reused chunk buffer.
+        ArenaScope scope(thread_arena());
+        LineImage last(line, tmpl, first + n);
+        // Lines only grow along the chunk, so the last one bounds them all
+        // (its timestamp slot is still empty here).
+        std::size_t widest = last.size() + (tmpl.timestamp ? kMaxTimestampChars : 0);
+        out.reserve(out.size() + static_cast<std::size_t>(n) * widest + 2 * kRunLines);
+
+        // Lines up to the first multiple of kRunLines, whole runs, the rest.
+        std::uint64_t number = first + 1;
+        std::uint64_t head = (kRunLines - number % kRunLines) % kRunLines;
+        if (!tmpl.sequence || head > n)
+            head = 0;
+        LineImage img(line, tmpl, number);
+        if (tmpl.timestamp)
+            img.stamp();
+        emit_lines(img, head, out);
+        number += head;
+        n -= head;
+        emit_runs(line, tmpl, number, n, out);
+        LineImage tail(line, tmpl, number);
+        if (tmpl.timestamp)
+            tail.stamp();
+        emit_lines(tail, n, out);
+    };
+}
+
+} // namespace garda
@@ -0,0 +1,29 @@
+#ifndef GARDA_LINE_TEMPLATE_H
+#define GARDA_LINE_TEMPLATE_H
+
+#include <string_view>
+
+#include "parallel_gen.h"
+
+namespace garda {
+
+// Per-line fields appended to the greeting, in this order:
+// "Hello world! #123456 1760716800.123\n".
+struct LineTemplate {
+    // " #N" with N counting from 1 across the whole output.
+    bool sequence = false;
+    // " seconds.mmm" of CLOCK_REALTIME_COARSE when the line was rendered.
+    bool timestamp = false;
+};
+
+// Filler that renders line (its trailing newline moved after the fields)
+// with the fields of tmpl. Each chunk keeps one rendered line and patches
+// it in place: the sequence number is bumped with increment_decimal() and
+// the timestamp is re-rendered only when the clock moves, so a line costs
+// about one short memcpy. With several threads, timestamps follow render
+// order and may step back across chunk boundaries.
+ChunkFiller template_filler(std::string_view line, const LineTemplate &tmpl);
+
+} // namespace garda
+
+#endif // GARDA_LINE_TEMPLATE_H
@@ -1,7 +1,242 @@
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <unistd.h>
+
+#include "batch.h"
+#include "catalog.h"
+#include "fd_sink.h"
+#include "frame.h"
+#include "greeting.h"
+#include "http.h"
+#include "line_format.h"
+#include "line_template.h"
+#include "mmap_file.h"
+#include "options.h"
+#include "output.h"
+#include "parallel_gen.h"
+#include "shm_channel.h"
+#include "snapshot.h"
+#include "splice_out.h"
+#include "stats.h"
+#include "tcp_server.h"
+#include "unix_service.h"
+#include "uring_sink.h"
+#include "zygote.h"
+
+#if !GARDA_OUTPUT_FD
 #include <iostream>
 
-int main() {
+#include "stream_sink.h"
+#endif
+
+int main(int argc, char **argv) {
     using namespace std;
-    cout << "Hello world!" << endl;
-    return 0;
+    garda::note_main();
+    garda::Options opts;
+    string error;
+    if (!garda::parse_options(argc, argv, opts, error)) {
+        fprintf(stderr, "%s\n%s", error.c_str(), garda::usage());
+        return 2;
+    }
+    if (opts.help) {
+        fputs(garda::usage(), stdout);
+        return 0;
+    }
+    if (opts.stats && !garda::enable_stats())
+        fputs("--stats: built without GARDA_STATS, no statistics collected\n", stderr);
+
+    garda::CatalogFile catalog;
+    if (!opts.catalog.empty() && !catalog.load(opts.catalog, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    garda::Snapshot snapshot;
+    if (!opts.snapshot.empty() && !snapshot.open(opts.snapshot, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    auto find = [&](string_view code) -> optional<garda::CatalogEntry> {
+        if (snapshot.is_open())
+            return snapshot.find(code);
+        const garda::CatalogEntry *e = catalog.find(code);
+        return e ? optional<garda::CatalogEntry>(*e) : nullopt;
+    };
+    optional<garda::CatalogEntry> lang;
+    if (!opts.lang.empty()) {
+        lang = garda::resolve_locale(opts.lang, find);
+        if (!lang) {
+            fprintf(stderr, "no greeting for language '%s'\n", opts.lang.c_str());
+            return 2;
+        }
+    } else if (snapshot.is_open()) {
+        // Resolved when the snapshot was written.
+        lang = garda::CatalogEntry{snapshot.lang(), snapshot.line()};
+    } else if (opts.catalog.empty()) {
+        lang = garda::greeting_from_environment();
+    } else {
+        string_view locale = garda::locale_from_environment();
+        if (!locale.empty())
+            lang = garda::resolve_locale(locale, find);
+        if (!lang)
+            lang = find(garda::default_greeting().lang);
+    }
+    // The built-in greeting has its wire forms rendered at compile time, a
+    // snapshot's greeting when the snapshot was written; anything else is
+    // rendered once here.
+    string_view greeting = lang->line;
+    bool builtin = greeting == garda::kGreeting;
+    bool snapped = snapshot.is_open() && greeting == snapshot.line();
+
+    garda::LineFormat format;
+    if (!opts.format.empty() && !format.compile(opts.format, greeting, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 2;
+    }
+
+    if (!opts.write_snapshot.empty()) {
+        garda::SnapshotContent content{lang->lang, greeting, catalog.merged()};
+        if (!garda::write_snapshot(opts.write_snapshot, content, error)) {
+            fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        return 0;
+    }
+
+    if (!opts.serve_unix.empty()) {
+        if (builtin)
+            return garda::serve_unix(opts.serve_unix, garda::kFramedGreeting);
+        if (snapped)
+            return garda::serve_unix(opts.serve_unix, snapshot.framed());
+        return garda::serve_unix(opts.serve_unix, garda::encode_frame(greeting));
+    }
+    if (opts.serve_tcp) {
+        garda::TcpServerConfig config;
+        config.port = opts.serve_tcp;
+        config.threads = opts.threads;
+        config.metrics_port = opts.metrics_port;
+        if (!opts.http)
+            return garda::serve_tcp(config, greeting);
+        config.protocol = garda::TcpProtocol::Http;
+        if (builtin)
+            return garda::serve_tcp(config, garda::kHttpGreeting);
+        if (snapped)
+            return garda::serve_tcp(config, snapshot.http());
+        return garda::serve_tcp(config, garda::render_http_response(greeting));
+    }
+    if (!opts.zygote.empty()) {
+        // Everything up to here, including the rendered reply, is done once;
+        // children only write.
+        garda::LineTemplate tmpl;
+        tmpl.sequence = opts.numbered;
+        tmpl.timestamp = opts.timestamps;
+        garda::ChunkFiller fill;
+        if (!opts.format.empty())
+            fill = garda::format_filler(format);
+        else if (opts.numbered || opts.timestamps)
+            fill = garda::template_filler(greeting, tmpl);
+        // Up to 64 KiB of plain lines, shared copy-on-write with every child,
+        // so a small request costs the child a single write().
+        string block;
+        while (!fill && !greeting.empty() && block.size() + greeting.size() <= 64 * 1024)
+            block += greeting;
+        return garda::serve_zygote(opts.zygote, [&](int fd, uint64_t count) {
+            garda::FdSink sink(fd);
+            if (!block.empty() && count <= block.size() / greeting.size())
+                return sink.write(block.data(), count * greeting.size()) ? 0 : 1;
+            if (!fill)
+                return garda::write_repeated(fd, greeting, count) ? 0 : 1;
+            garda::ParallelConfig config;
+            config.threads = 1;
+            return garda::generate_parallel(sink, count, fill, config) ? 0 : 1;
+        });
+    }
+    string fetched;
+    string_view reply = greeting;
+    if (!opts.connect_unix.empty()) {
+        if (!garda::request_unix(opts.connect_unix, fetched, error)) {
+            fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        reply = fetched;
+    }
+    if (!opts.output_file.empty()) {
+        if (!garda::generate_file(opts.output_file, reply, opts.count, opts.threads, error)) {
+            fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        return 0;
+    }
+    if (!opts.shm.empty()) {
+        // Same lines as on stdout, one shared-memory message each.
+        garda::ShmWriter writer;
+        if (!writer.create(opts.shm, 16384, error)) {
+            fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        writer.wait_for_readers(opts.shm_readers);
+        garda::ShmSink sink(writer);
+        garda::LineTemplate tmpl;
+        tmpl.sequence = opts.numbered;
+        tmpl.timestamp = opts.timestamps;
+        garda::ChunkFiller fill = !opts.format.empty() ? garda::format_filler(format)
+                                  : opts.numbered || opts.timestamps
+                                      ? garda::template_filler(reply, tmpl)
+                                      : garda::repeat_filler(reply);
+        garda::ParallelConfig config;
+        config.threads = opts.parallel ? opts.threads : 1;
+        bool ok = garda::generate_parallel(sink, opts.count, fill, config) && sink.sync();
+        writer.close();
+        if (!ok)
+            fprintf(stderr, "--shm: lines longer than %u bytes cannot be published\n",
+                    garda::kShmMaxPayload);
+        return ok ? 0 : 1;
+    }
+    if (!opts.format.empty() || opts.numbered || opts.timestamps) {
+        // Templated lines are rendered by the chunk pipeline; one filler
+        // thread unless --parallel asks for more.
+        garda::LineTemplate tmpl;
+        tmpl.sequence = opts.numbered;
+        tmpl.timestamp = opts.timestamps;
+        garda::ParallelConfig config;
+        config.threads = opts.parallel ? opts.threads : 1;
+        garda::FdSink sink(STDOUT_FILENO);
+        garda::ChunkFiller fill = !opts.format.empty() ? garda::format_filler(format)
+                                                       : garda::template_filler(reply, tmpl);
+        bool ok = garda::generate_parallel(sink, opts.count, fill, config);
+        return ok ? 0 : 1;
+    }
+    if (opts.parallel) {
+        garda::FdSink sink(STDOUT_FILENO);
+        garda::ParallelConfig config;
+        config.threads = opts.threads;
+        bool ok = garda::generate_parallel(sink, opts.count, garda::repeat_filler(reply), config);
+        return ok ? 0 : 1;
+    }
+    if (opts.io_uring) {
+        garda::UringConfig config;
+        config.queue_depth = opts.uring_depth;
+        garda::UringSink sink(STDOUT_FILENO, config);
+        return garda::write_repeated(sink, reply, opts.count, config.buffer_bytes) ? 0 : 1;
+    }
+    if (opts.zero_copy)
+        return garda::write_repeated_zero_copy(STDOUT_FILENO, reply, opts.count) ? 0 : 1;
+    if (opts.count != 1 && snapped && reply == greeting) {
+        bool ok = garda::write_lines_from_block(STDOUT_FILENO, snapshot.block(), reply.size(),
+                                                opts.count);
+        return ok ? 0 : 1;
+    }
+    if (opts.count != 1)
+        return garda::write_repeated(STDOUT_FILENO, reply, opts.count) ? 0 : 1;
+
+#if GARDA_OUTPUT_FD
+    garda::FdSink sink(STDOUT_FILENO);
+#else
+    garda::StreamSink sink(cout);
+#endif
+    garda::OutputBuffer out(sink);
+    out.append(reply);
+    return out.flush() ? 0 : 1;
 }
@@ -0,0 +1,78 @@
+#ifndef GARDA_MESSAGE_H
+#define GARDA_MESSAGE_H
+
+#include <cstddef>
+#include <string_view>
+
+namespace garda {
+
+// Fixed-size byte string usable in constant expressions. Messages built from
+// it (concatenation, length prefixes, decimal lengths) are assembled by the
+// compiler and end up as a single constant in .rodata.
+template <std::size_t N>
+struct FixedString {
+    char data[N + 1] = {};
+
+    constexpr FixedString() = default;
+    constexpr FixedString(const char (&s)[N + 1]) {
+        for (std::size_t i = 0; i < N; ++i)
+            data[i] = s[i];
+    }
+
+    static constexpr std::size_t size() { return N; }
+    constexpr std::string_view view() const { return std::string_view(data, N); }
+    constexpr char operator[](std::size_t i) const { return data[i]; }
+};
+
+template <std::size_t N>
+FixedString(const char (&)[N]) -> FixedString<N - 1>;
+
+template <std::size_t A, std::size_t B>
+constexpr FixedString<A + B> operator+(const FixedString<A> &a, const FixedString<B> &b) {
+    FixedString<A + B> out;
+    for (std::size_t i = 0; i < A; ++i)
+        out.data[i] = a.data[i];
+    for (std::size_t i = 0; i < B; ++i)
+        out.data[A + i] = b.data[i];
+    return out;
+}
+
+constexpr std::size_t decimal_digits(std::size_t v) {
+    std::size_t n = 1;
+    for (; v >= 10; v /= 10)
+        ++n;
+    return n;
+}
+
+template <std::size_t V>
+constexpr FixedString<decimal_digits(V)> decimal() {
+    FixedString<decimal_digits(V)> out;
+    std::size_t v = V;
+    for (std::size_t i = decimal_digits(V); i-- > 0; v /= 10)
+        out.data[i] = static_cast<char>('0' + v % 10);
+    return out;
+}
+
+// Payload preceded by its 4-byte little-endian length (see frame.h).
+template <std::size_t N>
+constexpr FixedString<4 + N> length_prefixed(const FixedString<N> &payload) {
+    static_assert(N <= 0xffffffffu, "payload does not fit a 32-bit length prefix");
+    FixedString<4> header;
+    for (std::size_t i = 0; i < 4; ++i)
+        header.data[i] = static_cast<char>((N >> (8 * i)) & 0xff);
+    return header + payload;
+}
+
+// Complete HTTP/1.1 200 response with body as text/plain; matches
+// render_http_response() in http.h byte for byte.
+template <std::size_t N>
+constexpr auto http_response(const FixedString<N> &body) {
+    return FixedString("HTTP/1.1 200 OK\r\n"
+                       "Content-Type: text/plain; charset=utf-8\r\n"
+                       "Content-Length: ") +
+           decimal<N>() + FixedString("\r\n\r\n") + body;
+}
+
+} // namespace garda
+
+#endif // GARDA_MESSAGE_H
@@ -0,0 +1,158 @@
+#include "metrics.h"
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "http.h"
+#include "signals.h"
+#include "tcp_server.h"
+
+namespace garda {
+
+namespace {
+
+constexpr int kStopPollMs = 100;
+constexpr int kScrapeTimeoutMs = 1000;
+constexpr std::size_t kRequestBytes = 4096;
+
+void append_counter(std::string &out, const char *name, const char *help, std::uint64_t v) {
+    char line[128];
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += " counter\n";
+    std::snprintf(line, sizeof(line), "%s %" PRIu64 "\n", name, v);
+    out += line;
+}
+
+// Reads one request, waiting at most kScrapeTimeoutMs for each step, and
+// answers it.
+void answer(int fd, const Metrics &metrics) {
+    char buf[kRequestBytes];
+    std::size_t len = 0;
+    HttpRequest req;
+    for (;;) {
+        pollfd p = {fd, POLLIN, 0};
+        if (::poll(&p, 1, kScrapeTimeoutMs) <= 0)
+            return;
+        ssize_t n = ::read(fd, buf + len, sizeof(buf) - len);
+        if (n <= 0)
+            return;
+        len += static_cast<std::size_t>(n);
+        HttpParse r = parse_http_request(buf, len, req);
+        if (r == HttpParse::Invalid)
+            return;
+        if (r == HttpParse::Complete)
+            break;
+        if (len == sizeof(buf))
+            return;
+    }
+    std::string_view head(buf, len);
+    std::string reply;
+    if (head.compare(0, 13, "GET /metrics ") == 0)
+        reply = render_http_response(metrics.render(), "text/plain; version=0.0.4");
+    else
+        reply = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+    const char *p = reply.data();
+    std::size_t left = reply.size();
+    while (left > 0) {
+        ssize_t n = ::send(fd, p, left, MSG_NOSIGNAL);
+        if (n < 0 && errno == EAGAIN) {
+            pollfd out = {fd, POLLOUT, 0};
+            if (::poll(&out, 1, kScrapeTimeoutMs) > 0)
+                continue;
+        }
+        if (n <= 0)
+            return;
+        p += n;
+        left -= static_cast<std::size_t>(n);
+    }
+}
+
+void run_endpoint(int listener, const Metrics &metrics) {
+    while (!stop_requested()) {
+        pollfd p = {listener, POLLIN, 0};
+        if (::poll(&p, 1, kStopPollMs) <= 0)
+            continue;
+        int fd = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+            continue;
+        answer(fd, metrics);
+        ::close(fd);
+    }
+}
+
+} // namespace
+
+Metrics::Metrics(unsigned shards)
+    : shards_(new MetricsShard[shards ? shards : 1]), count_(shards ? shards : 1) {}
+
+std::string Metrics::render() const {
+    std::uint64_t requests = 0, bytes = 0, connections = 0, sum_ns = 0;
+    std::uint64_t buckets[kLatencyBuckets + 1] = {};
+    for (unsigned i = 0; i < count_; ++i) {
+        const MetricsShard &s = shards_[i];
+        requests += s.requests.load(std::memory_order_relaxed);
+        bytes += s.bytes.load(std::memory_order_relaxed);
+        connections += s.connections.load(std::memory_order_relaxed);
+        sum_ns += s.latency_sum_ns.load(std::memory_order_relaxed);
+        for (unsigned b = 0; b <= kLatencyBuckets; ++b)
+            buckets[b] += s.latency[b].load(std::memory_order_relaxed);
+    }
+
+    std::string out;
+    append_counter(out, "garda_requests_total", "Greetings served.", requests);
+    append_counter(out, "garda_sent_bytes_total", "Bytes handed to the kernel.", bytes);
+    append_counter(out, "garda_connections_total", "Connections accepted.", connections);
+    out += "# HELP garda_request_duration_seconds Time from reading a request to sending "
+           "its reply.\n"
+           "# TYPE garda_request_duration_seconds histogram\n";
+    // _count is derived from the buckets, so the series agree even while
+    // workers keep recording.
+    char line[512];
+    std::uint64_t cumulative = 0;
+    for (unsigned b = 0; b < kLatencyBuckets; ++b) {
+        cumulative += buckets[b];
+        double le = static_cast<double>(std::uint64_t(1) << (b + 10)) / 1e9;
+        std::snprintf(line, sizeof(line),
+                      "garda_request_duration_seconds_bucket{le=\"%.10g\"} %" PRIu64 "\n", le,
+                      cumulative);
+        out += line;
+    }
+    cumulative += buckets[kLatencyBuckets];
+    std::snprintf(line, sizeof(line),
+                  "garda_request_duration_seconds_bucket{le=\"+Inf\"} %" PRIu64 "\n"
+                  "garda_request_duration_seconds_sum %.9f\n"
+                  "garda_request_duration_seconds_count %" PRIu64 "\n",
+                  cumulative, static_cast<double>(sum_ns) / 1e9, cumulative);
+    out += line;
+    return out;
+}
+
+MetricsEndpoint::~MetricsEndpoint() {
+    if (thread_.joinable())
+        thread_.join();
+    if (listener_ >= 0)
+        ::close(listener_);
+}
+
+bool MetricsEndpoint::start(std::uint16_t port, const Metrics &metrics, std::string &error) {
+    listener_ = listen_tcp(port);
+    if (listener_ < 0) {
+        error = "127.0.0.1:" + std::to_string(port) + ": " + std::strerror(errno);
+        return false;
+    }
+    thread_ = std::thread(run_endpoint, listener_, std::cref(metrics));
+    return true;
+}
+
+} // namespace garda
@@ -0,0 +1,89 @@
+#ifndef GARDA_METRICS_H
+#define GARDA_METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <time.h>
+
+namespace garda {
+
+// Latency histogram bucket i counts samples of at most 2^(i + 10) ns, i.e.
+// 1.024 us up to ~0.54 s; one more bucket takes everything slower.
+constexpr unsigned kLatencyBuckets = 20;
+
+inline std::uint64_t monotonic_ns() {
+    timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000u +
+           static_cast<std::uint64_t>(ts.tv_nsec);
+}
+
+// Counters owned by one server thread. Only that thread writes them, so an
+// update is a relaxed load and store (a plain add, no locked instruction);
+// scrapes read them with relaxed loads from another thread. Each shard has
+// its own cache lines.
+struct alignas(64) MetricsShard {
+    std::atomic<std::uint64_t> requests{0};
+    std::atomic<std::uint64_t> bytes{0};
+    std::atomic<std::uint64_t> connections{0};
+    std::atomic<std::uint64_t> latency_sum_ns{0};
+    std::atomic<std::uint64_t> latency[kLatencyBuckets + 1] = {};
+
+    static void bump(std::atomic<std::uint64_t> &a, std::uint64_t n) {
+        a.store(a.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    void add_bytes(std::uint64_t n) { bump(bytes, n); }
+    void add_connection() { bump(connections, 1); }
+
+    // Records n requests that each took ns to answer.
+    void observe(std::uint64_t ns, std::uint64_t n = 1) {
+        unsigned b = ns <= 1024 ? 0 : 64 - static_cast<unsigned>(__builtin_clzll(ns - 1)) - 10;
+        bump(requests, n);
+        bump(latency_sum_ns, ns * n);
+        bump(latency[b < kLatencyBuckets ? b : kLatencyBuckets], n);
+    }
+};
+
+// One shard per server thread, merged into the Prometheus text exposition
+// format (version 0.0.4) on scrape.
+class Metrics {
+public:
+    explicit Metrics(unsigned shards);
+
+    MetricsShard &shard(unsigned i) { return shards_[i]; }
+    unsigned shards() const { return count_; }
+
+    std::string render() const;
+
+private:
+    std::unique_ptr<MetricsShard[]> shards_;
+    unsigned count_;
+};
+
+// Serves metrics as text on http://127.0.0.1:port/metrics from a background
+// thread until stop_requested(). One scrape at a time; scrapes are rare.
+class MetricsEndpoint {
+public:
+    MetricsEndpoint() = default;
+    ~MetricsEndpoint();
+
+    MetricsEndpoint(const MetricsEndpoint &) = delete;
+    MetricsEndpoint &operator=(const MetricsEndpoint &) = delete;
+
+    // Binds the port and starts the thread; on failure stores a message in
+    // error and returns false.
+    bool start(std::uint16_t port, const Metrics &metrics, std::string &error);
+
+private:
+    int listener_ = -1;
+    std::thread thread_;
+};
+
+} // namespace garda
+
+#endif // GARDA_METRICS_H
@@ -0,0 +1,80 @@
+#include "mmap_file.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "pattern_fill.h"
+#include "stats.h"
+#include "thread_util.h"
+
+namespace garda {
+
+bool generate_file(const std::string &path, std::string_view line, std::uint64_t count,
+                   unsigned threads, std::string &error) {
+    std::uint64_t total = count * line.size();
+    if (!line.empty() && total / line.size() != count) {
+        error = "output size overflows";
+        return false;
+    }
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        error = path + ": " + std::strerror(errno);
+        return false;
+    }
+    if (total == 0) {
+        ::close(fd);
+        return true;
+    }
+    // Reserve the blocks up front: a store into a sparse mapping that finds
+    // the disk or quota full raises SIGBUS instead of returning an error.
+    // Only file systems without fallocate get a sparse file.
+    int err = ::posix_fallocate(fd, 0, static_cast<off_t>(total));
+    if (err == EOPNOTSUPP)
+        err = ::ftruncate(fd, static_cast<off_t>(total)) == 0 ? 0 : errno;
+    if (err != 0) {
+        error = path + ": " + std::strerror(err);
+        ::ftruncate(fd, 0);
+        ::close(fd);
+        return false;
+    }
+    void *mem = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mem == MAP_FAILED) {
+        error = path + ": " + std::strerror(errno);
+        ::close(fd);
+        return false;
+    }
+    char *base = static_cast<char *>(mem);
+    ::madvise(base, total, MADV_SEQUENTIAL);
+
+    // Split by whole lines so every worker starts at phase 0 of the line.
+    unsigned workers = resolve_thread_count(threads);
+    std::uint64_t per_worker = (count + workers - 1) / workers;
+    std::vector<std::thread> pool;
+    for (unsigned w = 0; w < workers; ++w) {
+        std::uint64_t first = per_worker * w;
+        if (first >= count)
+            break;
+        std::uint64_t lines = std::min(per_worker, count - first);
+        char *dst = base + first * line.size();
+        std::size_t n = static_cast<std::size_t>(lines * line.size());
+        pool.emplace_back([dst, n, line] { fill_pattern(dst, n, line); });
+    }
+    for (std::thread &t : pool)
+        t.join();
+    note_bytes(total);
+
+    bool ok = ::munmap(mem, total) == 0;
+    ok = ::close(fd) == 0 && ok;
+    if (!ok)
+        error = path + ": " + std::strerror(errno);
+    return ok;
+}
+
+} // namespace garda
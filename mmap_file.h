@@ -0,0 +1,22 @@
+#ifndef GARDA_MMAP_FILE_H
+#define GARDA_MMAP_FILE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace garda {
+
+// Creates (or replaces) the file at path holding line repeated count times.
+// The blocks are reserved up front with posix_fallocate(), so a full disk
+// is reported here rather than as SIGBUS while filling; file systems
+// without fallocate get a sparse file from ftruncate() instead. The file
+// is then mapped with mmap() and filled by threads workers (0 = one per
+// CPU) with fill_pattern(), each owning a contiguous range that starts on
+// a line boundary. Returns false with a message in error on failure.
+bool generate_file(const std::string &path, std::string_view line, std::uint64_t count,
+                   unsigned threads, std::string &error);
+
+} // namespace garda
+
+#endif // GARDA_MMAP_FILE_H
@@ -0,0 +1,226 @@
+#include "options.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+namespace garda {
+
+namespace {
+
+bool parse_u64(const char *s, std::uint64_t &out) {
+    if (!s || !*s || *s == '-')
+        return false;
+    char *end = nullptr;
+    errno = 0;
+    unsigned long long v = std::strtoull(s, &end, 10);
+    if (errno || *end)
+        return false;
+    out = v;
+    return true;
+}
+
+} // namespace
+
+bool parse_options(int argc, char **argv, Options &opts, std::string &error) {
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!std::strcmp(arg, "--help") || !std::strcmp(arg, "-h")) {
+            opts.help = true;
+        } else if (!std::strcmp(arg, "--stats")) {
+            opts.stats = true;
+        } else if (!std::strcmp(arg, "--count")) {
+            if (!parse_u64(value, opts.count)) {
+                error = "--count expects a non-negative integer";
+                return false;
+            }
+            ++i;
+        } else if (!std::strcmp(arg, "--zero-copy")) {
+            opts.zero_copy = true;
+        } else if (!std::strcmp(arg, "--io-uring")) {
+            opts.io_uring = true;
+        } else if (!std::strcmp(arg, "--uring-depth")) {
+            std::uint64_t depth = 0;
+            if (!parse_u64(value, depth) || depth == 0 || depth > 4096) {
+                error = "--uring-depth expects a count in 1..4096";
+                return false;
+            }
+            opts.uring_depth = static_cast<unsigned>(depth);
+            ++i;
+        } else if (!std::strcmp(arg, "--parallel")) {
+            opts.parallel = true;
+        } else if (!std::strcmp(arg, "--numbered")) {
+            opts.numbered = true;
+        } else if (!std::strcmp(arg, "--timestamps")) {
+            opts.timestamps = true;
+        } else if (!std::strcmp(arg, "--format")) {
+            if (!value || !*value) {
+                error = "--format expects a template, e.g. '{greeting} #{n}'";
+                return false;
+            }
+            opts.format = value;
+            ++i;
+        } else if (!std::strcmp(arg, "--output-file")) {
+            if (!value || !*value) {
+                error = "--output-file expects a path";
+                return false;
+            }
+            opts.output_file = value;
+            ++i;
+        } else if (!std::strcmp(arg, "--shm")) {
+            if (!value || !*value || std::strchr(value, '/')) {
+                error = "--shm expects a channel name without '/'";
+                return false;
+            }
+            opts.shm = value;
+            ++i;
+        } else if (!std::strcmp(arg, "--shm-readers")) {
+            std::uint64_t readers = 0;
+            if (!parse_u64(value, readers) || readers > 16) {
+                error = "--shm-readers expects a count in 0..16";
+                return false;
+            }
+            opts.shm_readers = static_cast<unsigned>(readers);
+            ++i;
+        } else if (!std::strcmp(arg, "--catalog") || !std::strcmp(arg, "--snapshot") ||
+                   !std::strcmp(arg, "--write-snapshot")) {
+            if (!value || !*value) {
+                error = std::string(arg) + " expects a path";
+                return false;
+            }
+            (!std::strcmp(arg, "--catalog")    ? opts.catalog
+             : !std::strcmp(arg, "--snapshot") ? opts.snapshot
+                                               : opts.write_snapshot) = value;
+            ++i;
+        } else if (!std::strcmp(arg, "--lang")) {
+            if (!value || !*value) {
+                error = "--lang expects a language code such as ru or pt_BR";
+                return false;
+            }
+            opts.lang = value;
+            ++i;
+        } else if (!std::strcmp(arg, "--zygote")) {
+            if (!value || !*value) {
+                error = "--zygote expects a socket path";
+                return false;
+            }
+            opts.zygote = value;
+            ++i;
+        } else if (!std::strcmp(arg, "--serve-unix") || !std::strcmp(arg, "--connect")) {
+            if (!value || !*value) {
+                error = std::string(arg) + " expects a socket path";
+                return false;
+            }
+            (std::strcmp(arg, "--connect") ? opts.serve_unix : opts.connect_unix) = value;
+            ++i;
+        } else if (!std::strcmp(arg, "--serve-tcp") || !std::strcmp(arg, "--serve-http")) {
+            std::uint64_t port = 0;
+            if (!parse_u64(value, port) || port == 0 || port > 65535) {
+                error = std::string(arg) + " expects a port in 1..65535";
+                return false;
+            }
+            opts.serve_tcp = static_cast<std::uint16_t>(port);
+            opts.http = !std::strcmp(arg, "--serve-http");
+            ++i;
+        } else if (!std::strcmp(arg, "--metrics-port")) {
+            std::uint64_t port = 0;
+            if (!parse_u64(value, port) || port == 0 || port > 65535) {
+                error = "--metrics-port expects a port in 1..65535";
+                return false;
+            }
+            opts.metrics_port = static_cast<std::uint16_t>(port);
+            ++i;
+        } else if (!std::strcmp(arg, "--threads")) {
+            std::uint64_t threads = 0;
+            if (!parse_u64(value, threads) || threads > 4096) {
+                error = "--threads expects a count in 0..4096 (0 = all cores)";
+                return false;
+            }
+            opts.threads = static_cast<unsigned>(threads);
+            ++i;
+        } else {
+            error = std::string("unknown argument: ") + arg;
+            return false;
+        }
+    }
+    if (opts.metrics_port && (!opts.serve_tcp || opts.metrics_port == opts.serve_tcp)) {
+        error = "--metrics-port needs --serve-tcp or --serve-http on a different port";
+        return false;
+    }
+    if ((opts.numbered || opts.timestamps) &&
+        (opts.zero_copy || opts.io_uring || !opts.output_file.empty())) {
+        error = "--numbered and --timestamps cannot be combined with "
+                "--zero-copy, --io-uring or --output-file";
+        return false;
+    }
+    if (!opts.format.empty() &&
+        (opts.numbered || opts.timestamps || opts.zero_copy || opts.io_uring ||
+         !opts.output_file.empty() || !opts.serve_unix.empty() || !opts.connect_unix.empty() ||
+         opts.serve_tcp)) {
+        error = "--format takes the place of --numbered and --timestamps ({n}, {time}) and "
+                "cannot be combined with --zero-copy, --io-uring, --output-file or servers";
+        return false;
+    }
+    if (!opts.shm.empty() && (opts.zero_copy || opts.io_uring || !opts.output_file.empty())) {
+        error = "--shm cannot be combined with --zero-copy, --io-uring or --output-file";
+        return false;
+    }
+    if (!opts.zygote.empty() &&
+        (!opts.serve_unix.empty() || !opts.connect_unix.empty() || opts.serve_tcp ||
+         !opts.output_file.empty() || !opts.shm.empty() || opts.zero_copy || opts.io_uring ||
+         opts.parallel)) {
+        error = "--zygote only combines with --numbered, --timestamps, --format and --lang";
+        return false;
+    }
+    if (!opts.snapshot.empty() && (!opts.catalog.empty() || !opts.write_snapshot.empty())) {
+        error = "--snapshot already holds the catalog; it cannot be combined with "
+                "--catalog or --write-snapshot";
+        return false;
+    }
+    if (opts.shm_readers && opts.shm.empty()) {
+        error = "--shm-readers needs --shm";
+        return false;
+    }
+    return true;
+}
+
+const char *usage() {
+    return "usage: Tets_GARDA [--count N [--zero-copy | --io-uring [--uring-depth D] | --parallel]]\n"
+           "                  [--numbered] [--timestamps] [--format TEMPLATE]\n"
+           "                  [--output-file PATH | --shm NAME [--shm-readers N]] [--lang CODE]\n"
+           "                  [--serve-unix PATH | --connect PATH | --zygote PATH]\n"
+           "                  [--serve-tcp PORT | --serve-http PORT] [--metrics-port PORT]\n"
+           "                  [--catalog FILE] [--snapshot FILE | --write-snapshot FILE]\n"
+           "                  [--threads N] [--stats]\n"
+           "  --count N            print the greeting N times (default 1)\n"
+           "  --zero-copy          with --count, vmsplice() pages into a pipe on stdout\n"
+           "  --io-uring           with --count, submit writes through io_uring\n"
+           "  --uring-depth D      io_uring writes kept in flight (default 8)\n"
+           "  --parallel           with --count, render chunks on --threads threads\n"
+           "  --numbered           append \" #N\" to every line, N counting from 1\n"
+           "  --timestamps         append the time the line was rendered (seconds.mmm)\n"
+           "  --format TEMPLATE    line layout, e.g. '{greeting} from {host}[{pid}] #{n} {time}';\n"
+           "                       {{ and }} are literal braces\n"
+           "  --output-file PATH   write the --count lines into PATH through mmap\n"
+           "  --shm NAME           publish the --count lines into /dev/shm/NAME, one per message\n"
+           "  --shm-readers N      with --shm, wait until N readers are attached\n"
+           "  --lang CODE          greeting language (default: LC_ALL, LC_MESSAGES, LANG)\n"
+           "  --catalog FILE       extra greetings, one \"code<TAB>greeting\" per line\n"
+           "  --write-snapshot FILE  save the resolved greeting, its rendered forms and the\n"
+           "                       catalog to FILE and exit\n"
+           "  --snapshot FILE      start from FILE (mapped read-only) instead of resolving\n"
+           "                       and rendering; without --lang, use its language\n"
+           "  --serve-unix PATH    answer greeting requests on a Unix socket\n"
+           "  --connect PATH       fetch one greeting from a --serve-unix server\n"
+           "  --zygote PATH        fork server: each request on PATH forks a child of this\n"
+           "                       initialized process to write greetings to the client's fd\n"
+           "  --serve-tcp PORT     send the greeting to every TCP connection on 127.0.0.1\n"
+           "  --serve-http PORT    serve the greeting over HTTP/1.1 on 127.0.0.1\n"
+           "  --metrics-port PORT  Prometheus metrics at http://127.0.0.1:PORT/metrics\n"
+           "  --threads N          worker threads for servers, --parallel and --output-file\n"
+           "                       (default: all cores)\n"
+           "  --stats              print phase timings and write counters as JSON on stderr\n";
+}
+
+} // namespace garda
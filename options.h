@@ -0,0 +1,64 @@
+#ifndef GARDA_OPTIONS_H
+#define GARDA_OPTIONS_H
+
+#include <cstdint>
+#include <string>
+
+namespace garda {
+
+struct Options {
+    std::uint64_t count = 1;
+    // Hand --count output to a pipe with vmsplice() instead of writev().
+    bool zero_copy = false;
+    // Stream --count output through io_uring with this many buffers in
+    // flight (--io-uring, --uring-depth).
+    bool io_uring = false;
+    unsigned uring_depth = 8;
+    // Render --count lines on --threads threads, written in order.
+    bool parallel = false;
+    // Append a sequence number and/or a timestamp to every --count line.
+    bool numbered = false;
+    bool timestamps = false;
+    // Line layout with fields (--format); empty means the plain greeting.
+    std::string format;
+    // Write --count lines into this file via mmap instead of stdout.
+    std::string output_file;
+    // Publish --count lines into the shared-memory channel /dev/shm/<name>
+    // instead of stdout, once shm_readers readers have attached (--shm,
+    // --shm-readers).
+    std::string shm;
+    unsigned shm_readers = 0;
+    bool help = false;
+    // Print timings and I/O counters as JSON on stderr at exit (--stats).
+    bool stats = false;
+    // Language code or locale name (--lang); empty means use the environment.
+    std::string lang;
+    // Extra greetings from a "code<TAB>greeting" file (--catalog).
+    std::string catalog;
+    // Start from a snapshot written earlier instead of resolving and
+    // rendering (--snapshot), or write one and exit (--write-snapshot).
+    std::string snapshot;
+    std::string write_snapshot;
+    // Unix socket path to serve on (--serve-unix) or to query (--connect).
+    std::string serve_unix;
+    std::string connect_unix;
+    // Unix socket path of the fork server (--zygote): each request forks a
+    // child of the initialized process to write the greetings.
+    std::string zygote;
+    // TCP port on 127.0.0.1 to serve on (--serve-tcp, or --serve-http for
+    // the HTTP/1.1 responder) and the number of worker threads.
+    std::uint16_t serve_tcp = 0;
+    bool http = false;
+    unsigned threads = 0;
+    // Port for the Prometheus metrics endpoint of the TCP/HTTP server.
+    std::uint16_t metrics_port = 0;
+};
+
+// Parses argv into opts; on failure stores a message in error and returns false.
+bool parse_options(int argc, char **argv, Options &opts, std::string &error);
+
+const char *usage();
+
+} // namespace garda
+
+#endif // GARDA_OPTIONS_H
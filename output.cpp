@@ -0,0 +1,94 @@
+#include "output.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "stats.h"
+
+namespace garda {
+
+namespace {
+
+OutputBuffer *registered = nullptr;
+bool atexit_installed = false;
+
+} // namespace
+
+OutputBuffer::OutputBuffer(Sink &sink, const OutputConfig &config)
+    : sink_(sink),
+      data_(new char[config.capacity ? config.capacity : 1]),
+      capacity_(config.capacity ? config.capacity : 1),
+      threshold_(config.flush_threshold && config.flush_threshold < capacity_
+                     ? config.flush_threshold
+                     : capacity_),
+      flush_on_exit_(config.flush_on_exit) {
+    if (flush_on_exit_) {
+        next_ = registered;
+        registered = this;
+        if (!atexit_installed) {
+            atexit_installed = true;
+            std::atexit(flush_registered_buffers);
+        }
+    }
+}
+
+OutputBuffer::~OutputBuffer() {
+    if (!flush_on_exit_)
+        return;
+    flush();
+    for (OutputBuffer **p = &registered; *p; p = &(*p)->next_) {
+        if (*p == this) {
+            *p = next_;
+            break;
+        }
+    }
+}
+
+void OutputBuffer::append(const char *data, std::size_t n) {
+    if (n > capacity_ - used_) {
+        drain();
+        if (n >= capacity_) {
+            ++flushes_;
+            note_flush();
+            ok_ = sink_.write(data, n) && ok_;
+            return;
+        }
+    }
+    std::memcpy(data_.get() + used_, data, n);
+    used_ += n;
+    maybe_flush();
+}
+
+void OutputBuffer::put(char c) {
+    if (used_ == capacity_)
+        drain();
+    data_[used_++] = c;
+    maybe_flush();
+}
+
+bool OutputBuffer::flush() {
+    drain();
+    ok_ = sink_.sync() && ok_;
+    return ok_;
+}
+
+void OutputBuffer::drain() {
+    if (used_) {
+        ++flushes_;
+        note_flush();
+        ok_ = sink_.write(data_.get(), used_) && ok_;
+        used_ = 0;
+    }
+}
+
+void OutputBuffer::maybe_flush() {
+    if (used_ >= threshold_)
+        drain();
+}
+
+void flush_registered_buffers() {
+    for (OutputBuffer *b = registered; b; b = b->next_)
+        b->flush();
+}
+
+} // namespace garda
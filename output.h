@@ -0,0 +1,82 @@
+#ifndef GARDA_OUTPUT_H
+#define GARDA_OUTPUT_H
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+
+namespace garda {
+
+// Destination for flushed bytes. Every call to write() that reaches the
+// operating system is counted so callers can report syscalls per line.
+class Sink {
+public:
+    virtual ~Sink() = default;
+
+    // Writes all n bytes, or takes a copy to write asynchronously; data may
+    // be reused once this returns. Returns false on an unrecoverable error.
+    virtual bool write(const char *data, std::size_t n) = 0;
+
+    // Waits until every accepted byte has been handed to the operating
+    // system. Synchronous sinks have nothing to wait for.
+    virtual bool sync() { return true; }
+
+    std::size_t writes() const { return writes_; }
+
+protected:
+    std::size_t writes_ = 0;
+};
+
+struct OutputConfig {
+    std::size_t capacity = 64 * 1024;
+    // Flush as soon as this many bytes are pending; 0 means "when full".
+    std::size_t flush_threshold = 0;
+    // Flush pending bytes from the destructor and from std::atexit.
+    bool flush_on_exit = true;
+};
+
+// Accumulates output in memory and hands it to a Sink only at explicit
+// flush points, when the threshold is crossed, or at exit.
+class OutputBuffer {
+public:
+    explicit OutputBuffer(Sink &sink, const OutputConfig &config = OutputConfig());
+    ~OutputBuffer();
+
+    OutputBuffer(const OutputBuffer &) = delete;
+    OutputBuffer &operator=(const OutputBuffer &) = delete;
+
+    void append(const char *data, std::size_t n);
+    void append(std::string_view s) { append(s.data(), s.size()); }
+    void put(char c);
+
+    // Hands pending bytes to the sink and waits for it to complete them.
+    bool flush();
+
+    std::size_t size() const { return used_; }
+    std::size_t capacity() const { return capacity_; }
+    std::size_t flushes() const { return flushes_; }
+    bool ok() const { return ok_; }
+
+private:
+    friend void flush_registered_buffers();
+
+    void maybe_flush();
+    void drain();
+
+    Sink &sink_;
+    std::unique_ptr<char[]> data_;
+    std::size_t capacity_;
+    std::size_t threshold_;
+    std::size_t used_ = 0;
+    std::size_t flushes_ = 0;
+    bool ok_ = true;
+    bool flush_on_exit_;
+    OutputBuffer *next_ = nullptr;
+};
+
+// Flushes every live buffer created with flush_on_exit; runs from std::atexit.
+void flush_registered_buffers();
+
+} // namespace garda
+
+#endif // GARDA_OUTPUT_H
@@ -0,0 +1,111 @@
+#include "parallel_gen.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "pattern_fill.h"
+#include "thread_util.h"
+
+namespace garda {
+
+namespace {
+
+struct Slot {
+    enum State { Free, Filling, Ready } state = Free;
+    // Chunk this slot may hold next; advances by the slot count.
+    std::uint64_t chunk = 0;
+    std::string buf;
+};
+
+struct Pipeline {
+    std::mutex mu;
+    std::condition_variable freed;
+    std::condition_variable filled;
+    std::vector<Slot> slots;
+    std::atomic<std::uint64_t> next{0};
+    bool abort = false;
+};
+
+void filler(Pipeline &p, std::uint64_t count, std::uint64_t chunks, std::uint64_t per_chunk,
+            const ChunkFiller &fill) {
+    for (;;) {
+        std::uint64_t i = p.next.fetch_add(1, std::memory_order_relaxed);
+        if (i >= chunks)
+            return;
+        Slot &slot = p.slots[i % p.slots.size()];
+        {
+            std::unique_lock<std::mutex> lock(p.mu);
+            p.freed.wait(lock, [&] {
+                return p.abort || (slot.state == Slot::Free && slot.chunk == i);
+            });
+            if (p.abort)
+                return;
+            slot.state = Slot::Filling;
+        }
+        std::uint64_t first = i * per_chunk;
+        slot.buf.clear();
+        fill(first, std::min(per_chunk, count - first), slot.buf);
+        {
+            std::lock_guard<std::mutex> lock(p.mu);
+            slot.state = Slot::Ready;
+        }
+        p.filled.notify_one();
+    }
+}
+
+} // namespace
+
+bool generate_parallel(Sink &sink, std::uint64_t count, const ChunkFiller &fill,
+                       const ParallelConfig &config) {
+    if (count == 0)
+        return sink.sync();
+    unsigned threads = resolve_thread_count(config.threads);
+    std::uint64_t per_chunk = std::max<std::uint64_t>(1, config.lines_per_chunk);
+    std::uint64_t chunks = (count + per_chunk - 1) / per_chunk;
+    if (threads > chunks)
+        threads = static_cast<unsigned>(chunks);
+    unsigned in_flight = config.chunks_in_flight ? config.chunks_in_flight : 2 * threads;
+
+    Pipeline p;
+    p.slots.resize(std::max(in_flight, threads));
+    for (std::size_t s = 0; s < p.slots.size(); ++s)
+        p.slots[s].chunk = s;
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; ++t)
+        pool.emplace_back(filler, std::ref(p), count, chunks, per_chunk, std::cref(fill));
+
+    bool ok = true;
+    for (std::uint64_t i = 0; i < chunks && ok; ++i) {
+        Slot &slot = p.slots[i % p.slots.size()];
+        {
+            std::unique_lock<std::mutex> lock(p.mu);
+            p.filled.wait(lock, [&] { return slot.state == Slot::Ready && slot.chunk == i; });
+        }
+        ok = sink.write(slot.buf.data(), slot.buf.size());
+        {
+            std::lock_guard<std::mutex> lock(p.mu);
+            slot.state = Slot::Free;
+            slot.chunk += p.slots.size();
+            p.abort = !ok;
+        }
+        p.freed.notify_all();
+    }
+    for (std::thread &t : pool)
+        t.join();
+    return sink.sync() && ok;
+}
+
+ChunkFiller repeat_filler(std::string_view line) {
+    return [line](std::uint64_t, std::uint64_t n, std::string &out) {
+        std::size_t at = out.size();
+        out.resize(at + static_cast<std::size_t>(n) * line.size());
+        fill_pattern(&out[at], out.size() - at, line);
+    };
+}
+
+} // namespace garda
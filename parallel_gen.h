@@ -0,0 +1,37 @@
+#ifndef GARDA_PARALLEL_GEN_H
+#define GARDA_PARALLEL_GEN_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include "output.h"
+
+namespace garda {
+
+// Appends lines [first, first + n) of the output stream to out. Must be
+// safe to call from several threads at once for disjoint ranges.
+using ChunkFiller = std::function<void(std::uint64_t first, std::uint64_t n, std::string &out)>;
+
+struct ParallelConfig {
+    // Filler threads; 0 means one per CPU.
+    unsigned threads = 0;
+    std::uint64_t lines_per_chunk = 64 * 1024;
+    // Chunk buffers shared by fillers and the writer; 0 means 2 per thread.
+    unsigned chunks_in_flight = 0;
+};
+
+// Produces count lines with a pool of filler threads, each rendering whole
+// chunks into its own buffer, while the calling thread hands finished
+// chunks to sink strictly in chunk order. The output is byte-identical to
+// calling fill() once for the whole range. Returns false if the sink fails.
+bool generate_parallel(Sink &sink, std::uint64_t count, const ChunkFiller &fill,
+                       const ParallelConfig &config = ParallelConfig());
+
+// Filler that repeats line.
+ChunkFiller repeat_filler(std::string_view line);
+
+} // namespace garda
+
+#endif // GARDA_PARALLEL_GEN_H
@@ -0,0 +1,253 @@
+#include "pattern_fill.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define GARDA_FILL_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define GARDA_FILL_NEON 1
+#endif
+
+namespace garda {
+
+namespace {
+
+// Largest rotation kept in the staging buffer; longer periods use scalar.
+constexpr std::size_t kMaxStage = 8192;
+// Fills at least this large bypass the cache with non-temporal stores.
+constexpr std::size_t kStreamBytes = 8 << 20;
+
+std::size_t gcd(std::size_t a, std::size_t b) {
+    while (b) {
+        std::size_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// Copies n bytes of the pattern stream starting at phase; returns the new phase.
+std::size_t copy_phase(char *dst, std::size_t n, std::string_view p, std::size_t phase) {
+    while (n > 0) {
+        std::size_t chunk = p.size() - phase;
+        if (chunk > n)
+            chunk = n;
+        std::memcpy(dst, p.data() + phase, chunk);
+        dst += chunk;
+        n -= chunk;
+        phase = (phase + chunk) % p.size();
+    }
+    return phase;
+}
+
+void fill_scalar(char *dst, std::size_t n, std::string_view p, std::size_t phase) {
+    // Seed one period, then keep doubling the filled prefix; every copy
+    // length is a multiple of the period so the phase carries over.
+    // Copies are capped at about 1 MiB of whole periods, and at one period
+    // when the pattern itself is longer.
+    constexpr std::size_t kMaxCopy = std::size_t(1) << 20;
+    std::size_t cap = p.size() >= kMaxCopy ? p.size() : kMaxCopy - kMaxCopy % p.size();
+    std::size_t first = n < p.size() ? n : p.size();
+    copy_phase(dst, first, p, phase);
+    std::size_t filled = first;
+    while (filled < n) {
+        std::size_t chunk = filled;
+        if (chunk > n - filled)
+            chunk = n - filled;
+        if (chunk > cap)
+            chunk = cap;
+        std::memcpy(dst + filled, dst, chunk);
+        filled += chunk;
+    }
+}
+
+struct Stage {
+    alignas(64) char bytes[kMaxStage];
+    std::size_t len;
+};
+
+// Lays out lcm(pattern, width) bytes of the pattern stream from phase.
+bool build_stage(Stage &s, std::string_view p, std::size_t phase, std::size_t width) {
+    s.len = p.size() / gcd(p.size(), width) * width;
+    if (s.len > kMaxStage)
+        return false;
+    copy_phase(s.bytes, s.len, p, phase);
+    return true;
+}
+
+// Shared driver: scalar head up to width alignment, vector body, tail from
+// the stage. Kernel::store/stream copy one vector from the stage to dst.
+template <typename Kernel>
+inline void fill_vector(char *dst, std::size_t n, std::string_view p, std::size_t phase) {
+    constexpr std::size_t W = Kernel::kWidth;
+    std::size_t head = (W - reinterpret_cast<std::uintptr_t>(dst) % W) % W;
+    if (head > n)
+        head = n;
+    phase = copy_phase(dst, head, p, phase);
+    dst += head;
+    n -= head;
+
+    Stage s;
+    if (!build_stage(s, p, phase, W)) {
+        fill_scalar(dst, n, p, phase);
+        return;
+    }
+    std::size_t regs = s.len / W;
+    std::size_t rounds = n / s.len;
+    if (n >= kStreamBytes) {
+        for (std::size_t i = 0; i < rounds; ++i, dst += s.len)
+            for (std::size_t r = 0; r < regs; ++r)
+                Kernel::stream(dst + r * W, s.bytes + r * W);
+        Kernel::fence();
+    } else {
+        for (std::size_t i = 0; i < rounds; ++i, dst += s.len)
+#pragma GCC unroll 8
+            for (std::size_t r = 0; r < regs; ++r)
+                Kernel::store(dst + r * W, s.bytes + r * W);
+    }
+    std::memcpy(dst, s.bytes, n - rounds * s.len);
+}
+
+#if GARDA_FILL_X86
+
+struct Sse2Kernel {
+    static constexpr std::size_t kWidth = 16;
+    static void store(char *dst, const char *src) {
+        _mm_store_si128(reinterpret_cast<__m128i *>(dst),
+                        _mm_load_si128(reinterpret_cast<const __m128i *>(src)));
+    }
+    static void stream(char *dst, const char *src) {
+        _mm_stream_si128(reinterpret_cast<__m128i *>(dst),
+                         _mm_load_si128(reinterpret_cast<const __m128i *>(src)));
+    }
+    static void fence() { _mm_sfence(); }
+};
+
+struct Avx2Kernel {
+    static constexpr std::size_t kWidth = 32;
+    __attribute__((target("avx2"))) static void store(char *dst, const char *src) {
+        _mm256_store_si256(reinterpret_cast<__m256i *>(dst),
+                           _mm256_load_si256(reinterpret_cast<const __m256i *>(src)));
+    }
+    __attribute__((target("avx2"))) static void stream(char *dst, const char *src) {
+        _mm256_stream_si256(reinterpret_cast<__m256i *>(dst),
+                            _mm256_load_si256(reinterpret_cast<const __m256i *>(src)));
+    }
+    static void fence() { _mm_sfence(); }
+};
+
+void fill_sse2(char *dst, std::size_t n, std::string_view p, std::size_t phase) {
+    fill_vector<Sse2Kernel>(dst, n, p, phase);
+}
+
+// flatten pulls the generic driver into this AVX2-enabled function, so the
+// stores are inlined without compiling the whole file with -mavx2.
+__attribute__((target("avx2"), flatten)) void fill_avx2(char *dst, std::size_t n,
+                                                        std::string_view p, std::size_t phase) {
+    fill_vector<Avx2Kernel>(dst, n, p, phase);
+}
+
+#endif
+
+#if GARDA_FILL_NEON
+
+struct NeonKernel {
+    static constexpr std::size_t kWidth = 16;
+    static void store(char *dst, const char *src) {
+        vst1q_u8(reinterpret_cast<std::uint8_t *>(dst),
+                 vld1q_u8(reinterpret_cast<const std::uint8_t *>(src)));
+    }
+    static void stream(char *dst, const char *src) { store(dst, src); }
+    static void fence() {}
+};
+
+void fill_neon(char *dst, std::size_t n, std::string_view p, std::size_t phase) {
+    fill_vector<NeonKernel>(dst, n, p, phase);
+}
+
+#endif
+
+FillIsa detect_isa() {
+#if GARDA_FILL_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return FillIsa::Avx2;
+    return FillIsa::Sse2;
+#elif GARDA_FILL_NEON
+    return FillIsa::Neon;
+#else
+    return FillIsa::Scalar;
+#endif
+}
+
+} // namespace
+
+FillIsa fill_isa() {
+    static const FillIsa isa = detect_isa();
+    return isa;
+}
+
+bool fill_isa_supported(FillIsa isa) {
+    switch (isa) {
+    case FillIsa::Scalar:
+        return true;
+    case FillIsa::Sse2:
+        return fill_isa() == FillIsa::Sse2 || fill_isa() == FillIsa::Avx2;
+    case FillIsa::Avx2:
+    case FillIsa::Neon:
+        return fill_isa() == isa;
+    }
+    return false;
+}
+
+const char *fill_isa_name(FillIsa isa) {
+    switch (isa) {
+    case FillIsa::Scalar:
+        return "scalar";
+    case FillIsa::Sse2:
+        return "sse2";
+    case FillIsa::Avx2:
+        return "avx2";
+    case FillIsa::Neon:
+        return "neon";
+    }
+    return "?";
+}
+
+void fill_pattern_with(FillIsa isa, char *dst, std::size_t n, std::string_view pattern,
+                       std::size_t phase) {
+    if (n == 0 || pattern.empty())
+        return;
+    phase %= pattern.size();
+    switch (isa) {
+#if GARDA_FILL_X86
+    case FillIsa::Avx2:
+        fill_avx2(dst, n, pattern, phase);
+        return;
+    case FillIsa::Sse2:
+        fill_sse2(dst, n, pattern, phase);
+        return;
+#endif
+#if GARDA_FILL_NEON
+    case FillIsa::Neon:
+        fill_neon(dst, n, pattern, phase);
+        return;
+#endif
+    default:
+        fill_scalar(dst, n, pattern, phase);
+    }
+}
+
+void fill_pattern(char *dst, std::size_t n, std::string_view pattern, std::size_t phase) {
+    // While the destination fits in cache, libc's memcpy doubling the filled
+    // prefix is already at store bandwidth. Past that it has to read back
+    // what it wrote, whereas the vector kernels only read the L1-resident
+    // stage and bypass the cache.
+    FillIsa isa = n >= kStreamBytes ? fill_isa() : FillIsa::Scalar;
+    fill_pattern_with(isa, dst, n, pattern, phase);
+}
+
+} // namespace garda
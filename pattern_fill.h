@@ -0,0 +1,29 @@
+#ifndef GARDA_PATTERN_FILL_H
+#define GARDA_PATTERN_FILL_H
+
+#include <cstddef>
+#include <string_view>
+
+namespace garda {
+
+enum class FillIsa { Scalar, Sse2, Avx2, Neon };
+
+// Fills [dst, dst + n) with pattern repeated endlessly, starting phase bytes
+// into it. Large fills use the widest vector kernel the CPU supports (chosen
+// once at first use): the pattern is laid out across lcm(pattern, vector
+// width) bytes, i.e. a small rotation of registers (13 for the 13-byte
+// greeting), which are stored back to back with aligned non-temporal
+// stores. Fills that fit in cache use memcpy doubling instead.
+void fill_pattern(char *dst, std::size_t n, std::string_view pattern, std::size_t phase = 0);
+
+// Same, forcing one kernel; isa must be supported (see fill_isa_supported).
+void fill_pattern_with(FillIsa isa, char *dst, std::size_t n, std::string_view pattern,
+                       std::size_t phase = 0);
+
+FillIsa fill_isa();
+bool fill_isa_supported(FillIsa isa);
+const char *fill_isa_name(FillIsa isa);
+
+} // namespace garda
+
+#endif // GARDA_PATTERN_FILL_H
@@ -0,0 +1,390 @@
+#include "shm_channel.h"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "stats.h"
+
+namespace garda {
+
+namespace {
+
+constexpr std::uint64_t kMagic = 0x314d485344524147ULL; // "GARDSHM1"
+constexpr std::uint32_t kVersion = 2;
+// Polls of an empty (reader) or full (writer) ring before going to sleep.
+constexpr int kIdleSpins = 64;
+// Longest sleep of a writer on a full ring. Readers wake it without a
+// fence, so a wake-up can be missed; this bounds what that costs, and how
+// long a dead reader holds up the writer before it is dropped.
+constexpr timespec kWriterSleep = {0, 1000000};
+
+// Shared between processes, so neither futex call may be _PRIVATE.
+void futex_wait(std::atomic<std::uint32_t> &word, std::uint32_t expected,
+                const timespec *timeout = nullptr) {
+    ::syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&word), FUTEX_WAIT, expected, timeout,
+              nullptr, 0);
+}
+
+void futex_wake_all(std::atomic<std::uint32_t> &word) {
+    ::syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&word), FUTEX_WAKE, INT_MAX, nullptr,
+              nullptr, 0);
+}
+
+bool shm_path(const std::string &name, std::string &path, std::string &error) {
+    if (name.empty() || name.size() > NAME_MAX - 1 || name.find('/') != std::string::npos) {
+        error = "shared memory channel name must be non-empty and contain no '/': " + name;
+        return false;
+    }
+    path = "/" + name;
+    return true;
+}
+
+} // namespace
+
+struct ShmSlot {
+    std::atomic<std::uint64_t> seq;
+    std::uint32_t len;
+    std::uint32_t reserved;
+    char data[kShmMaxPayload];
+};
+
+struct alignas(64) ShmReaderSlot {
+    // Owning process, 0 when free.
+    std::atomic<std::int32_t> pid;
+    // Next message the reader will take.
+    std::atomic<std::uint64_t> cursor;
+};
+
+struct ShmChannelHeader {
+    // Stored last by the writer, once the rest is initialized.
+    std::atomic<std::uint64_t> magic;
+    std::uint32_t version;
+    std::uint32_t slot_bytes;
+    std::uint64_t slots;
+    alignas(64) std::atomic<std::uint64_t> published;
+    std::atomic<std::uint32_t> closed;
+    // Readers asleep, and the futex word they sleep on.
+    alignas(64) std::atomic<std::uint32_t> waiters;
+    std::atomic<std::uint32_t> wake_seq;
+    // While the writer sleeps on a full ring: the cursor a reader must
+    // reach to wake it (0 otherwise), and the futex word it sleeps on.
+    alignas(64) std::atomic<std::uint64_t> writer_wake_at;
+    std::atomic<std::uint32_t> writer_seq;
+    ShmReaderSlot readers[kShmMaxReaders];
+
+    ShmSlot *ring() { return reinterpret_cast<ShmSlot *>(this + 1); }
+};
+
+static_assert(sizeof(ShmSlot) == kShmSlotBytes, "slot layout");
+static_assert(sizeof(ShmChannelHeader) % 64 == 0, "ring must start cache-line aligned");
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+              "shared atomics must not depend on a per-process lock");
+
+ShmWriter::~ShmWriter() {
+    if (header_) {
+        close();
+        ::munmap(header_, map_bytes_);
+    }
+}
+
+bool ShmWriter::create(const std::string &name, std::size_t slots, std::string &error) {
+    std::string path;
+    if (!shm_path(name, path, error))
+        return false;
+    std::uint64_t cap = 2;
+    while (cap < slots)
+        cap *= 2;
+    std::size_t bytes = sizeof(ShmChannelHeader) + static_cast<std::size_t>(cap) * kShmSlotBytes;
+
+    ::shm_unlink(path.c_str());
+    int fd = ::shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        error = "shm_open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        error = "ftruncate " + path + ": " + std::strerror(errno);
+        ::close(fd);
+        ::shm_unlink(path.c_str());
+        return false;
+    }
+    void *mem = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED) {
+        error = "mmap " + path + ": " + std::strerror(errno);
+        ::shm_unlink(path.c_str());
+        return false;
+    }
+    // ftruncate() zero-filled the object: every counter and slot sequence
+    // starts at 0.
+    header_ = new (mem) ShmChannelHeader;
+    map_bytes_ = bytes;
+    header_->version = kVersion;
+    header_->slot_bytes = kShmSlotBytes;
+    header_->slots = cap;
+    header_->magic.store(kMagic, std::memory_order_release);
+    next_ = 0;
+    limit_ = 0;
+    return true;
+}
+
+void ShmWriter::wait_for_readers(unsigned n) {
+    for (;;) {
+        unsigned active = 0;
+        for (ShmReaderSlot &r : header_->readers)
+            active += r.pid.load(std::memory_order_acquire) != 0;
+        if (active >= n)
+            return;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+bool ShmWriter::refresh_gate() {
+    std::uint64_t low = next_;
+    for (ShmReaderSlot &r : header_->readers) {
+        if (!r.pid.load(std::memory_order_acquire))
+            continue;
+        std::uint64_t c = r.cursor.load(std::memory_order_acquire);
+        if (c < low)
+            low = c;
+    }
+    limit_ = low + header_->slots;
+    return next_ < limit_;
+}
+
+bool ShmWriter::put(std::string_view msg) {
+    if (msg.size() > kShmMaxPayload)
+        return false;
+    if (next_ >= limit_ && !refresh_gate())
+        wait_for_room();
+    ShmSlot &s = header_->ring()[next_ & (header_->slots - 1)];
+    s.seq.store(2 * next_ + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    s.len = static_cast<std::uint32_t>(msg.size());
+    std::memcpy(s.data, msg.data(), msg.size());
+    s.seq.store(2 * next_ + 2, std::memory_order_release);
+    header_->published.store(++next_, std::memory_order_release);
+    note_bytes(msg.size());
+    return true;
+}
+
+void ShmWriter::wait_for_room() {
+    // The slowest reader is a ring behind: make sure it is awake, poll
+    // briefly, then sleep until it has freed half the ring, the way a
+    // writer on a full pipe does. Readers whose process is gone are
+    // dropped so they cannot stall us forever.
+    notify();
+    for (int spins = 1; !refresh_gate(); ++spins) {
+        if (spins < kIdleSpins) {
+            std::this_thread::yield();
+            continue;
+        }
+        std::uint32_t seen = header_->writer_seq.load(std::memory_order_acquire);
+        header_->writer_wake_at.store(next_ - header_->slots / 2, std::memory_order_seq_cst);
+        if (!refresh_gate())
+            futex_wait(header_->writer_seq, seen, &kWriterSleep);
+        header_->writer_wake_at.store(0, std::memory_order_relaxed);
+        for (ShmReaderSlot &r : header_->readers) {
+            std::int32_t pid = r.pid.load(std::memory_order_relaxed);
+            if (pid && ::kill(pid, 0) != 0 && errno == ESRCH)
+                r.pid.compare_exchange_strong(pid, 0);
+        }
+    }
+}
+
+void ShmWriter::notify() {
+    // Pairs with the increment of waiters in ShmReader::read(): either the
+    // reader sees the messages before sleeping or we see it asleep.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (header_->waiters.load(std::memory_order_relaxed))
+        wake_readers();
+}
+
+void ShmWriter::close() {
+    if (!header_ || header_->closed.load(std::memory_order_relaxed))
+        return;
+    header_->closed.store(1, std::memory_order_seq_cst);
+    wake_readers();
+}
+
+void ShmWriter::wake_readers() {
+    header_->wake_seq.fetch_add(1, std::memory_order_release);
+    futex_wake_all(header_->wake_seq);
+}
+
+ShmReader::~ShmReader() {
+    if (!header_)
+        return;
+    if (reader_ >= 0)
+        header_->readers[reader_].pid.store(0, std::memory_order_release);
+    ::munmap(header_, map_bytes_);
+}
+
+bool ShmReader::open(const std::string &name, std::string &error) {
+    std::string path;
+    if (!shm_path(name, path, error))
+        return false;
+    int fd = ::shm_open(path.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        error = "shm_open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(ShmChannelHeader)) {
+        error = path + ": not a greeting channel (or not initialized yet)";
+        ::close(fd);
+        return false;
+    }
+    std::size_t bytes = static_cast<std::size_t>(st.st_size);
+    void *mem = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED) {
+        error = "mmap " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    auto *h = static_cast<ShmChannelHeader *>(mem);
+    if (h->magic.load(std::memory_order_acquire) != kMagic || h->version != kVersion ||
+        h->slot_bytes != kShmSlotBytes ||
+        sizeof(ShmChannelHeader) + h->slots * kShmSlotBytes != bytes) {
+        error = path + ": not a greeting channel (or not initialized yet)";
+        ::munmap(mem, bytes);
+        return false;
+    }
+    header_ = h;
+    map_bytes_ = bytes;
+
+    // Park the cursor at the current position before claiming a slot so
+    // the writer never sees a registered reader with a stale cursor, then
+    // start from wherever the writer is once registered.
+    auto pid = static_cast<std::int32_t>(::getpid());
+    for (unsigned i = 0; i < kShmMaxReaders && reader_ < 0; ++i) {
+        ShmReaderSlot &r = h->readers[i];
+        std::int32_t free = 0;
+        if (r.pid.load(std::memory_order_relaxed))
+            continue;
+        r.cursor.store(h->published.load(std::memory_order_acquire), std::memory_order_relaxed);
+        if (r.pid.compare_exchange_strong(free, pid, std::memory_order_seq_cst))
+            reader_ = static_cast<int>(i);
+    }
+    advance(h->published.load(std::memory_order_seq_cst));
+    return true;
+}
+
+void ShmReader::advance(std::uint64_t next) {
+    next_ = next;
+    if (reader_ < 0)
+        return;
+    header_->readers[reader_].cursor.store(next, std::memory_order_release);
+    std::uint64_t wake_at = header_->writer_wake_at.load(std::memory_order_relaxed);
+    if (wake_at && next >= wake_at) {
+        header_->writer_wake_at.store(0, std::memory_order_relaxed);
+        header_->writer_seq.fetch_add(1, std::memory_order_release);
+        futex_wake_all(header_->writer_seq);
+    }
+}
+
+ShmReader::Status ShmReader::try_read(std::string_view &msg) {
+    const std::uint64_t slots = header_->slots;
+    for (;;) {
+        const ShmSlot &s = header_->ring()[next_ & (slots - 1)];
+        const std::uint64_t want = 2 * next_ + 2;
+        std::uint64_t seq = s.seq.load(std::memory_order_acquire);
+        if (seq < want) {
+            // closed is stored after the last message, so check it first.
+            if (header_->closed.load(std::memory_order_acquire) &&
+                s.seq.load(std::memory_order_acquire) < want)
+                return Status::Closed;
+            return Status::Empty;
+        }
+        if (seq == want) {
+            std::uint32_t len = s.len;
+            if (len <= kShmMaxPayload) {
+                // A fixed-size copy inlines to a few vector moves; a libc
+                // call for ~30 bytes costs several times more.
+                std::memcpy(buf_, s.data, sizeof buf_);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (s.seq.load(std::memory_order_relaxed) == want) {
+                    msg = std::string_view(buf_, len);
+                    advance(next_ + 1);
+                    return Status::Message;
+                }
+            }
+        }
+        // Lapped: skip to the oldest message that can still be intact.
+        std::uint64_t published = header_->published.load(std::memory_order_acquire);
+        std::uint64_t oldest = published >= slots ? published - slots + 1 : 0;
+        if (oldest <= next_)
+            oldest = next_ + 1;
+        lost_ += oldest - next_;
+        advance(oldest);
+    }
+}
+
+ShmReader::Status ShmReader::read(std::string_view &msg) {
+    for (int spins = 0;;) {
+        Status st = try_read(msg);
+        if (st != Status::Empty)
+            return st;
+        if (++spins < kIdleSpins) {
+            std::this_thread::yield();
+            continue;
+        }
+        header_->waiters.fetch_add(1, std::memory_order_seq_cst);
+        std::uint32_t seen = header_->wake_seq.load(std::memory_order_acquire);
+        st = try_read(msg);
+        if (st == Status::Empty)
+            futex_wait(header_->wake_seq, seen);
+        header_->waiters.fetch_sub(1, std::memory_order_relaxed);
+        if (st != Status::Empty)
+            return st;
+        spins = 0;
+    }
+}
+
+bool ShmSink::write(const char *data, std::size_t n) {
+    const char *end = data + n;
+    while (data < end) {
+        const char *nl = static_cast<const char *>(std::memchr(data, '\n', end - data));
+        if (!nl) {
+            partial_.append(data, end);
+            break;
+        }
+        std::string_view line(data, static_cast<std::size_t>(nl + 1 - data));
+        if (!partial_.empty()) {
+            partial_.append(line.data(), line.size());
+            line = partial_;
+        }
+        if (!writer_.put(line)) {
+            writer_.notify();
+            return false;
+        }
+        partial_.clear();
+        data = nl + 1;
+    }
+    writer_.notify();
+    return true;
+}
+
+bool ShmSink::sync() {
+    if (partial_.empty())
+        return true;
+    bool ok = writer_.publish(partial_);
+    partial_.clear();
+    return ok;
+}
+
+} // namespace garda
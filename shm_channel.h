@@ -0,0 +1,138 @@
+#ifndef GARDA_SHM_CHANNEL_H
+#define GARDA_SHM_CHANNEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "output.h"
+
+namespace garda {
+
+// Broadcast channel of short messages (greeting lines) in a POSIX shared
+// memory object, /dev/shm/<name>. One writer process publishes into a ring
+// of fixed-size slots; any number of reader processes map it read-write
+// and follow along with plain loads, without syscalls while messages are
+// available. Each slot is a seqlock: its sequence number is odd while the
+// writer fills it and 2 * (message index + 1) once published, so a reader
+// that copied a slot can tell whether it was overwritten meanwhile.
+//
+// Readers register a cursor (up to kShmMaxReaders); the writer never laps
+// a registered reader, sleeping instead until it has caught up half the
+// ring, the way a writer on a full pipe blocks.
+// Readers that could not register, or whose process died and was dropped,
+// may fall behind and are told how many messages they lost. A reader that
+// finds the ring empty sleeps on a shared futex after a short spin, and
+// the writer only makes the wake-up syscall when someone is asleep.
+
+constexpr std::uint32_t kShmSlotBytes = 128;
+constexpr std::uint32_t kShmMaxPayload = kShmSlotBytes - 16;
+constexpr unsigned kShmMaxReaders = 16;
+
+struct ShmChannelHeader;
+
+class ShmWriter {
+public:
+    ShmWriter() = default;
+    ~ShmWriter();
+
+    ShmWriter(const ShmWriter &) = delete;
+    ShmWriter &operator=(const ShmWriter &) = delete;
+
+    // Creates /dev/shm/<name> with slots message slots (rounded up to a
+    // power of two), replacing any previous channel of that name. Readers
+    // that still map the old one keep it until they reopen.
+    bool create(const std::string &name, std::size_t slots, std::string &error);
+
+    // Waits until at least n readers have registered.
+    void wait_for_readers(unsigned n);
+
+    // Publishes one message of at most kShmMaxPayload bytes; waits while
+    // the slowest registered reader is a full ring behind. Returns false
+    // if the message is too long.
+    bool publish(std::string_view msg) {
+        if (!put(msg))
+            return false;
+        notify();
+        return true;
+    }
+
+    // publish() in two halves, for batches: put() makes a message visible
+    // to readers that are polling; notify() wakes readers that went to
+    // sleep, which costs a fence and, only if someone sleeps, a syscall.
+    bool put(std::string_view msg);
+    void notify();
+
+    // Marks the end of the stream; readers see closed once they have
+    // consumed every message. The object stays in /dev/shm.
+    void close();
+
+    std::uint64_t published() const { return next_; }
+
+private:
+    void wake_readers();
+    bool refresh_gate();
+    void wait_for_room();
+
+    ShmChannelHeader *header_ = nullptr;
+    std::size_t map_bytes_ = 0;
+    std::uint64_t next_ = 0;
+    // Messages below this index may be written without rescanning cursors.
+    std::uint64_t limit_ = 0;
+};
+
+class ShmReader {
+public:
+    enum class Status { Message, Empty, Closed };
+
+    ShmReader() = default;
+    ~ShmReader();
+
+    ShmReader(const ShmReader &) = delete;
+    ShmReader &operator=(const ShmReader &) = delete;
+
+    // Maps an existing channel and registers a cursor at the writer's
+    // current position, so the next message read is the next one
+    // published. Fails if the writer has not finished creating it yet.
+    bool open(const std::string &name, std::string &error);
+
+    // Takes the next message if one is published. msg points into this
+    // reader and stays valid until the next call.
+    Status try_read(std::string_view &msg);
+
+    // Like try_read(), but waits for a message or the end of the stream.
+    Status read(std::string_view &msg);
+
+    // Messages overwritten before this reader got to them.
+    std::uint64_t lost() const { return lost_; }
+    bool registered() const { return reader_ >= 0; }
+
+private:
+    void advance(std::uint64_t next);
+
+    ShmChannelHeader *header_ = nullptr;
+    std::size_t map_bytes_ = 0;
+    std::uint64_t next_ = 0;
+    std::uint64_t lost_ = 0;
+    int reader_ = -1;
+    char buf_[kShmMaxPayload];
+};
+
+// Sink that publishes every complete line written to it as one message,
+// newline included; sync() publishes a trailing partial line.
+class ShmSink : public Sink {
+public:
+    explicit ShmSink(ShmWriter &writer) : writer_(writer) {}
+
+    bool write(const char *data, std::size_t n) override;
+    bool sync() override;
+
+private:
+    ShmWriter &writer_;
+    std::string partial_;
+};
+
+} // namespace garda
+
+#endif // GARDA_SHM_CHANNEL_H
@@ -0,0 +1,30 @@
+#include "signals.h"
+
+#include <csignal>
+
+namespace garda {
+
+namespace {
+
+volatile std::sig_atomic_t stop_flag = 0;
+
+void on_stop(int) {
+    stop_flag = 1;
+}
+
+} // namespace
+
+void install_stop_handlers() {
+    struct sigaction sa = {};
+    sa.sa_handler = on_stop;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+    std::signal(SIGPIPE, SIG_IGN);
+}
+
+bool stop_requested() {
+    return stop_flag != 0;
+}
+
+} // namespace garda
@@ -0,0 +1,14 @@
+#ifndef GARDA_SIGNALS_H
+#define GARDA_SIGNALS_H
+
+namespace garda {
+
+// Installs SIGINT/SIGTERM handlers that only set a flag, and ignores SIGPIPE
+// so that a vanished peer surfaces as EPIPE instead of killing the server.
+void install_stop_handlers();
+
+bool stop_requested();
+
+} // namespace garda
+
+#endif // GARDA_SIGNALS_H
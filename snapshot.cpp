@@ -0,0 +1,198 @@
+#include "snapshot.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "frame.h"
+#include "http.h"
+#include "pattern_fill.h"
+
+namespace garda {
+
+namespace {
+
+constexpr char kMagic[8] = {'G', 'A', 'R', 'D', 'S', 'N', 'P', '1'};
+constexpr std::uint32_t kVersion = 1;
+constexpr std::size_t kBlockBytes = 64 * 1024;
+
+struct Span {
+    std::uint64_t offset;
+    std::uint64_t size;
+};
+
+struct FileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t reserved;
+    std::uint64_t file_bytes;
+    Span lang, line, framed, http, block;
+    // SnapshotEntry records and the open-addressing index over them: one
+    // uint32 per slot, entry number + 1, 0 for empty.
+    Span entries;
+    Span index;
+};
+
+std::uint64_t hash(std::string_view s) {
+    std::uint64_t h = 14695981039346656037ull;
+    for (char c : s) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ull;
+    }
+    return h ^ (h >> 29);
+}
+
+bool inside(const Span &s, std::size_t bytes) {
+    return s.offset <= bytes && s.size <= bytes - s.offset;
+}
+
+Span append(std::string &blob, std::string_view data) {
+    Span s = {blob.size(), data.size()};
+    blob.append(data.data(), data.size());
+    return s;
+}
+
+void align8(std::string &blob) {
+    blob.resize((blob.size() + 7) & ~std::size_t(7), '\0');
+}
+
+} // namespace
+
+struct SnapshotEntry {
+    Span lang;
+    Span line;
+};
+
+bool write_snapshot(const std::string &path, const SnapshotContent &content,
+                    std::string &error) {
+    std::string blob(sizeof(FileHeader), '\0');
+    FileHeader h = {};
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.version = kVersion;
+    h.lang = append(blob, content.lang);
+    h.line = append(blob, content.line);
+    h.framed = append(blob, encode_frame(content.line));
+    h.http = append(blob, render_http_response(content.line));
+    align8(blob);
+    std::size_t per_block = content.line.empty() ? 0 : kBlockBytes / content.line.size();
+    if (!content.line.empty() && per_block == 0)
+        per_block = 1;
+    h.block = {blob.size(), per_block * content.line.size()};
+    blob.resize(blob.size() + h.block.size);
+    fill_pattern(&blob[h.block.offset], h.block.size, content.line);
+
+    std::vector<SnapshotEntry> records;
+    records.reserve(content.catalog.size());
+    for (const CatalogEntry &e : content.catalog) {
+        Span lang = append(blob, e.lang);
+        records.push_back({lang, append(blob, e.line)});
+    }
+    std::size_t slots = 2;
+    while (slots < 2 * records.size())
+        slots *= 2;
+    std::vector<std::uint32_t> index(slots, 0);
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        std::size_t slot = hash(content.catalog[i].lang) & (slots - 1);
+        while (index[slot])
+            slot = (slot + 1) & (slots - 1);
+        index[slot] = static_cast<std::uint32_t>(i + 1);
+    }
+    align8(blob);
+    h.entries = {blob.size(), records.size() * sizeof(SnapshotEntry)};
+    blob.append(reinterpret_cast<const char *>(records.data()), h.entries.size);
+    h.index = {blob.size(), slots * sizeof(std::uint32_t)};
+    blob.append(reinterpret_cast<const char *>(index.data()), h.index.size);
+    h.file_bytes = blob.size();
+    std::memcpy(&blob[0], &h, sizeof(h));
+
+    std::string tmp = path + ".tmp." + std::to_string(::getpid());
+    std::FILE *f = std::fopen(tmp.c_str(), "wb");
+    bool ok = f && std::fwrite(blob.data(), 1, blob.size(), f) == blob.size();
+    ok = f && std::fclose(f) == 0 && ok;
+    if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        error = path + ": " + std::strerror(errno);
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+Snapshot::~Snapshot() {
+    if (base_)
+        ::munmap(const_cast<char *>(base_), bytes_);
+}
+
+bool Snapshot::open(const std::string &path, std::string &error) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error = path + ": " + std::strerror(errno);
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(FileHeader)) {
+        ::close(fd);
+        error = path + ": not a snapshot";
+        return false;
+    }
+    std::size_t bytes = static_cast<std::size_t>(st.st_size);
+    void *mem = ::mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED) {
+        error = path + ": " + std::strerror(errno);
+        return false;
+    }
+    const auto *base = static_cast<const char *>(mem);
+    FileHeader h;
+    std::memcpy(&h, base, sizeof(h));
+    bool ok = !std::memcmp(h.magic, kMagic, sizeof(kMagic)) && h.version == kVersion &&
+              h.file_bytes == bytes;
+    for (const Span *s : {&h.lang, &h.line, &h.framed, &h.http, &h.block, &h.entries, &h.index})
+        ok = ok && inside(*s, bytes);
+    std::size_t slots = static_cast<std::size_t>(h.index.size / sizeof(std::uint32_t));
+    ok = ok && h.entries.offset % 8 == 0 && h.entries.size % sizeof(SnapshotEntry) == 0 &&
+         h.index.offset % 4 == 0 && slots >= 2 && (slots & (slots - 1)) == 0 &&
+         h.entries.size / sizeof(SnapshotEntry) < slots;
+    if (!ok) {
+        ::munmap(mem, bytes);
+        error = path + ": not a snapshot, or written by another version";
+        return false;
+    }
+    base_ = base;
+    bytes_ = bytes;
+    auto view = [&](const Span &s) { return std::string_view(base + s.offset, s.size); };
+    lang_ = view(h.lang);
+    line_ = view(h.line);
+    framed_ = view(h.framed);
+    http_ = view(h.http);
+    block_ = view(h.block);
+    entry_table_ = reinterpret_cast<const SnapshotEntry *>(base + h.entries.offset);
+    entries_ = static_cast<std::size_t>(h.entries.size / sizeof(SnapshotEntry));
+    index_ = reinterpret_cast<const std::uint32_t *>(base + h.index.offset);
+    index_mask_ = slots - 1;
+    return true;
+}
+
+std::optional<CatalogEntry> Snapshot::find(std::string_view lang) const {
+    // Records are checked as they are used rather than all at open(), so
+    // opening costs the same however large the catalog is.
+    std::size_t slot = hash(lang) & index_mask_;
+    for (std::size_t probe = 0; probe <= index_mask_; ++probe, slot = (slot + 1) & index_mask_) {
+        std::uint32_t i = index_[slot];
+        if (i == 0 || i > entries_)
+            return std::nullopt;
+        const SnapshotEntry &e = entry_table_[i - 1];
+        if (!inside(e.lang, bytes_) || !inside(e.line, bytes_))
+            return std::nullopt;
+        if (std::string_view(base_ + e.lang.offset, e.lang.size) == lang)
+            return CatalogEntry{std::string_view(base_ + e.lang.offset, e.lang.size),
+                                std::string_view(base_ + e.line.offset, e.line.size)};
+    }
+    return std::nullopt;
+}
+
+} // namespace garda
@@ -0,0 +1,72 @@
+#ifndef GARDA_SNAPSHOT_H
+#define GARDA_SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "catalog.h"
+
+namespace garda {
+
+// What start-up computes, in the form a later process can use in place:
+// the greeting picked for the configured language, its wire forms (framed
+// for the Unix socket, the full HTTP response) and a 64 KiB block of
+// repeated lines for --count, plus the whole catalog with a prebuilt hash
+// index for --lang lookups.
+struct SnapshotContent {
+    std::string_view lang;
+    std::string_view line;
+    std::vector<CatalogEntry> catalog;
+};
+
+// Writes content to path (through a temporary file and rename(), so a
+// reader never maps a half-written snapshot).
+bool write_snapshot(const std::string &path, const SnapshotContent &content,
+                    std::string &error);
+
+struct SnapshotEntry;
+
+// A snapshot file mapped read-only. Opening validates the header and that
+// every offset lies inside the file, then nothing is parsed, copied or
+// built: the accessors return views into the mapping.
+class Snapshot {
+public:
+    Snapshot() = default;
+    ~Snapshot();
+
+    Snapshot(const Snapshot &) = delete;
+    Snapshot &operator=(const Snapshot &) = delete;
+
+    bool open(const std::string &path, std::string &error);
+
+    std::string_view lang() const { return lang_; }
+    std::string_view line() const { return line_; }
+    std::string_view framed() const { return framed_; }
+    std::string_view http() const { return http_; }
+    // Whole copies of line(), for write_lines_from_block().
+    std::string_view block() const { return block_; }
+
+    bool is_open() const { return base_ != nullptr; }
+
+    // Looks up an exact language code in the stored catalog.
+    std::optional<CatalogEntry> find(std::string_view lang) const;
+
+    std::size_t catalog_size() const { return entries_; }
+
+private:
+    const char *base_ = nullptr;
+    std::size_t bytes_ = 0;
+    std::string_view lang_, line_, framed_, http_, block_;
+    const SnapshotEntry *entry_table_ = nullptr;
+    const std::uint32_t *index_ = nullptr;
+    std::size_t entries_ = 0;
+    std::size_t index_mask_ = 0;
+};
+
+} // namespace garda
+
+#endif // GARDA_SNAPSHOT_H
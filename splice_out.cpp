@@ -0,0 +1,106 @@
+#include "splice_out.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "pattern_fill.h"
+#include "stats.h"
+
+namespace garda {
+
+namespace {
+
+constexpr std::size_t kTargetBytes = 4 << 20;
+constexpr std::size_t kMaxPatternBytes = 64 << 20;
+constexpr int kPipeBytes = 1 << 20;
+
+std::size_t gcd(std::size_t a, std::size_t b) {
+    while (b) {
+        std::size_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+bool is_pipe(int fd) {
+    struct stat st;
+    return ::fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode);
+}
+
+// vmsplice()s [data, data + n) completely. Returns 1 on success, 0 on a
+// write error and -1 if the kernel refused vmsplice before any byte moved.
+int vmsplice_all(int fd, const char *data, std::size_t n, BatchStats &st, bool first) {
+    while (n > 0) {
+        struct iovec iov = {const_cast<char *>(data), n};
+        ssize_t w = ::vmsplice(fd, &iov, 1, 0);
+        ++st.syscalls;
+        if (w < 0) {
+            if (errno == EINTR)
+                continue;
+            return first && (errno == EINVAL || errno == ENOSYS) ? -1 : 0;
+        }
+        first = false;
+        st.bytes += static_cast<std::uint64_t>(w);
+        note_write(static_cast<std::size_t>(w));
+        data += w;
+        n -= static_cast<std::size_t>(w);
+    }
+    return 1;
+}
+
+} // namespace
+
+bool write_repeated_zero_copy(int fd, std::string_view line, std::uint64_t count,
+                              BatchStats *stats) {
+    BatchStats local;
+    BatchStats &st = stats ? *stats : local;
+    if (count == 0 || line.empty())
+        return true;
+    if (!is_pipe(fd))
+        return write_repeated(fd, line, count, &st);
+
+    // One period is the smallest length that is a whole number of lines and
+    // a whole number of pages, so every page starts at a line boundary
+    // relative to the previous one.
+    std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    std::size_t period = line.size() / gcd(line.size(), page) * page;
+    if (period > kMaxPatternBytes)
+        return write_repeated(fd, line, count, &st);
+    std::size_t periods = period >= kTargetBytes ? 1 : kTargetBytes / period;
+    std::size_t map_len = period * periods;
+    std::uint64_t total = count * line.size();
+    if (total < map_len)
+        map_len = static_cast<std::size_t>((total + page - 1) / page * page);
+
+    void *mem = ::mmap(nullptr, map_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED)
+        return write_repeated(fd, line, count, &st);
+    char *buf = static_cast<char *>(mem);
+    fill_pattern(buf, map_len, line);
+    ::fcntl(fd, F_SETPIPE_SZ, kPipeBytes);
+
+    bool first = true;
+    int rc = 1;
+    std::uint64_t left = total;
+    while (left > 0 && rc == 1) {
+        std::size_t n = left < map_len ? static_cast<std::size_t>(left) : map_len;
+        rc = vmsplice_all(fd, buf, n, st, first);
+        first = false;
+        left -= n;
+    }
+    // Spliced pages stay referenced by the pipe; unmapping only drops ours.
+    ::munmap(mem, map_len);
+    if (rc < 0)
+        return write_repeated(fd, line, count, &st);
+    return rc == 1;
+}
+
+} // namespace garda
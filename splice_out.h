@@ -0,0 +1,22 @@
+#ifndef GARDA_SPLICE_OUT_H
+#define GARDA_SPLICE_OUT_H
+
+#include <cstdint>
+#include <string_view>
+
+#include "batch.h"
+
+namespace garda {
+
+// Same contract as write_repeated(), but when fd is a pipe the output is
+// handed over without copying: the line is replicated into a page-aligned
+// mapping whose length is a multiple of both the line and the page size,
+// and those pages are attached to the pipe with vmsplice(). The mapping is
+// never written again once spliced. Other fds, and pipes that reject
+// vmsplice(), fall back to write_repeated().
+bool write_repeated_zero_copy(int fd, std::string_view line, std::uint64_t count,
+                              BatchStats *stats = nullptr);
+
+} // namespace garda
+
+#endif // GARDA_SPLICE_OUT_H
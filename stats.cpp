@@ -0,0 +1,69 @@
+#include "stats.h"
+
+#if GARDA_STATS
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+
+#include <time.h>
+
+namespace garda {
+
+StatsCounters stats_counters;
+
+namespace {
+
+std::uint64_t entry_ns = 0;
+std::uint64_t main_ns = 0;
+
+std::uint64_t now_ns() {
+    timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000u +
+           static_cast<std::uint64_t>(ts.tv_nsec);
+}
+
+// Priority 101 is the first one available to programs, so this runs before
+// ordinary static initializers (iostream included).
+__attribute__((constructor(101))) void note_entry() {
+    entry_ns = now_ns();
+}
+
+void report() {
+    std::uint64_t exit_ns = now_ns();
+    StatsCounters &s = stats_counters;
+    std::uint64_t first = s.first_write_ns.load(std::memory_order_relaxed);
+    char first_text[24] = "null";
+    if (first)
+        std::snprintf(first_text, sizeof(first_text), "%" PRIu64, first - entry_ns);
+    std::fprintf(stderr,
+                 "{\"entry_monotonic_ns\":%" PRIu64 ",\"main_ns\":%" PRIu64
+                 ",\"first_write_ns\":%s,\"exit_ns\":%" PRIu64 ",\"bytes\":%" PRIu64
+                 ",\"writes\":%" PRIu64 ",\"flushes\":%" PRIu64 "}\n",
+                 entry_ns, main_ns - entry_ns, first_text, exit_ns - entry_ns,
+                 s.bytes.load(std::memory_order_relaxed), s.writes.load(std::memory_order_relaxed),
+                 s.flushes.load(std::memory_order_relaxed));
+}
+
+} // namespace
+
+void note_first_write() {
+    std::uint64_t expected = 0;
+    stats_counters.first_write_ns.compare_exchange_strong(expected, now_ns(),
+                                                          std::memory_order_relaxed);
+}
+
+void note_main() {
+    main_ns = now_ns();
+}
+
+bool enable_stats() {
+    if (!stats_counters.enabled.exchange(true))
+        std::atexit(report);
+    return true;
+}
+
+} // namespace garda
+
+#endif // GARDA_STATS
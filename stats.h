@@ -0,0 +1,81 @@
+#ifndef GARDA_STATS_H
+#define GARDA_STATS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace garda {
+
+// Process-wide instrumentation behind --stats: monotonic timestamps for
+// process entry (before other static initializers), main(), the first
+// write and exit, and counters for bytes written, write calls and buffer
+// flushes. The I/O paths call the note_*() hooks below. Built with
+// GARDA_STATS=0 every hook is an empty inline function; built with it but
+// without --stats, a hook is one relaxed load of the enabled flag.
+#if GARDA_STATS
+
+struct StatsCounters {
+    std::atomic<bool> enabled{false};
+    std::atomic<std::uint64_t> first_write_ns{0};
+    std::atomic<std::uint64_t> bytes{0};
+    std::atomic<std::uint64_t> writes{0};
+    std::atomic<std::uint64_t> flushes{0};
+};
+
+extern StatsCounters stats_counters;
+
+// Records the first-write timestamp once; kept out of line.
+void note_first_write();
+
+// One write call (write, writev, vmsplice, send, io_uring_enter) that
+// moved bytes to the kernel.
+inline void note_write(std::size_t bytes) {
+    StatsCounters &s = stats_counters;
+    if (!s.enabled.load(std::memory_order_relaxed))
+        return;
+    if (!s.first_write_ns.load(std::memory_order_relaxed))
+        note_first_write();
+    s.writes.fetch_add(1, std::memory_order_relaxed);
+    s.bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+// Bytes that reached the output without a write call of their own
+// (mmap'd files, io_uring completions, shared-memory channels).
+inline void note_bytes(std::size_t bytes) {
+    StatsCounters &s = stats_counters;
+    if (!s.enabled.load(std::memory_order_relaxed))
+        return;
+    if (!s.first_write_ns.load(std::memory_order_relaxed))
+        note_first_write();
+    s.bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+// A buffer handed its contents on (OutputBuffer drain, ostream flush).
+inline void note_flush() {
+    StatsCounters &s = stats_counters;
+    if (s.enabled.load(std::memory_order_relaxed))
+        s.flushes.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Records the time main() was entered, i.e. static initialization is done.
+void note_main();
+
+// Starts counting and prints the JSON report to stderr at exit. Call it
+// before creating OutputBuffers so their exit flush is counted. Returns
+// false when the binary was built without GARDA_STATS.
+bool enable_stats();
+
+#else
+
+inline void note_write(std::size_t) {}
+inline void note_bytes(std::size_t) {}
+inline void note_flush() {}
+inline void note_main() {}
+inline bool enable_stats() { return false; }
+
+#endif
+
+} // namespace garda
+
+#endif // GARDA_STATS_H
@@ -0,0 +1,15 @@
+#include "stream_sink.h"
+
+#include "stats.h"
+
+namespace garda {
+
+bool StreamSink::write(const char *data, std::size_t n) {
+    ++writes_;
+    os_.write(data, static_cast<std::streamsize>(n));
+    os_.flush();
+    note_write(n);
+    return static_cast<bool>(os_);
+}
+
+} // namespace garda
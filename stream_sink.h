@@ -0,0 +1,24 @@
+#ifndef GARDA_STREAM_SINK_H
+#define GARDA_STREAM_SINK_H
+
+#include <ostream>
+
+#include "output.h"
+
+namespace garda {
+
+// Sink that forwards each flushed block to a std::ostream with a single
+// write() followed by one flush(), instead of one flush per line.
+class StreamSink : public Sink {
+public:
+    explicit StreamSink(std::ostream &os) : os_(os) {}
+
+    bool write(const char *data, std::size_t n) override;
+
+private:
+    std::ostream &os_;
+};
+
+} // namespace garda
+
+#endif // GARDA_STREAM_SINK_H
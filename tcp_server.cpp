@@ -0,0 +1,378 @@
+#include "tcp_server.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "http.h"
+#include "metrics.h"
+#include "signals.h"
+#include "stats.h"
+#include "thread_util.h"
+
+namespace garda {
+
+namespace {
+
+constexpr int kMaxEvents = 256;
+constexpr int kStopPollMs = 100;
+constexpr std::size_t kReplyCopies = 64;
+constexpr std::size_t kInputBytes = 4096;
+
+constexpr std::string_view kNotAllowed = "HTTP/1.1 405 Method Not Allowed\r\n"
+                                         "Allow: GET, HEAD\r\n"
+                                         "Content-Length: 0\r\n\r\n";
+
+// Replies a connection can owe: the greeting for GET (and for every
+// connection of the greeting protocol), its headers alone for HEAD, and
+// 405 for any other method.
+enum ReplyKind : std::uint8_t { kGetReply, kHeadReply, kNotAllowedReply, kReplyKinds };
+
+struct Conn {
+    bool active = false;
+    bool close_after = false;
+    bool want_out = false;
+    // Parsing stopped at a request that needs a different reply than the
+    // owed ones; it resumes once they are sent.
+    bool stalled = false;
+    // Which reply the owed bytes repeat.
+    ReplyKind kind = kGetReply;
+    // Bytes of the endless reply stream that are owed and already sent.
+    std::uint64_t owed = 0;
+    std::uint64_t sent = 0;
+    // Requests whose replies are owed, and when the oldest was read.
+    std::uint64_t pending = 0;
+    std::uint64_t pending_since_ns = 0;
+    // Body bytes of a request too large for the buffer that are still to
+    // arrive; they are dropped as they are read.
+    std::uint64_t skip = 0;
+    std::size_t in_len = 0;
+    char in[kInputBytes];
+};
+
+struct Worker {
+    int listener = -1;
+    int ep = -1;
+    TcpProtocol protocol = TcpProtocol::Greeting;
+    // Per ReplyKind: the reply length and kReplyCopies back-to-back
+    // replies, so pipelined requests are answered from one contiguous span
+    // without copying or allocating.
+    std::size_t reply_len[kReplyKinds] = {};
+    std::string block[kReplyKinds];
+    // Connection state indexed by fd; slots are reused, never freed.
+    std::vector<Conn> conns;
+    // Null unless metrics are enabled. The clock is read when the loop
+    // wakes up and again after it has handled every event: requests read in
+    // this round are stamped with the first time and, if answered within
+    // the round, recorded together with the second.
+    MetricsShard *metrics = nullptr;
+    std::uint64_t woke_ns = 0;
+    std::uint64_t answered = 0;
+};
+
+// Sends owed bytes; returns false on a fatal socket error.
+bool flush_owed(Worker &w, int fd, Conn &c) {
+    const std::string &block = w.block[c.kind];
+    while (c.owed > c.sent) {
+        std::size_t off = static_cast<std::size_t>(c.sent % w.reply_len[c.kind]);
+        std::size_t len = block.size() - off;
+        if (c.owed - c.sent < len)
+            len = static_cast<std::size_t>(c.owed - c.sent);
+        ssize_t n = ::send(fd, block.data() + off, len, MSG_NOSIGNAL);
+        if (n < 0)
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        note_write(static_cast<std::size_t>(n));
+        if (w.metrics)
+            w.metrics->add_bytes(static_cast<std::uint64_t>(n));
+        c.sent += static_cast<std::size_t>(n);
+    }
+    c.owed = c.sent = 0;
+    if (w.metrics && c.pending) {
+        if (c.pending_since_ns == w.woke_ns)
+            w.answered += c.pending;
+        else
+            w.metrics->observe(monotonic_ns() - c.pending_since_ns, c.pending);
+        c.pending = 0;
+    }
+    return true;
+}
+
+// Counts a request whose reply is now owed.
+void note_request(Worker &w, Conn &c) {
+    if (!w.metrics)
+        return;
+    if (c.pending++ == 0)
+        c.pending_since_ns = w.woke_ns;
+}
+
+// Parses buffered requests, adding their replies to what is owed. A run of
+// owed bytes repeats one reply, so a request needing another kind stalls
+// parsing until the run is sent. A request whose body does not fit in the
+// buffer is answered as soon as its head is in, and the rest of the body
+// is skipped. Returns false on a malformed request.
+bool parse_buffered(Worker &w, Conn &c) {
+    std::size_t used = c.skip < c.in_len ? static_cast<std::size_t>(c.skip) : c.in_len;
+    c.skip -= used;
+    HttpRequest req;
+    c.stalled = false;
+    while (!c.close_after) {
+        HttpParse r = parse_http_request(c.in + used, c.in_len - used, req);
+        if (r == HttpParse::Invalid)
+            return false;
+        if (r == HttpParse::Incomplete && req.length <= kInputBytes)
+            break;
+        ReplyKind kind = req.method == HttpMethod::Get    ? kGetReply
+                         : req.method == HttpMethod::Head ? kHeadReply
+                                                          : kNotAllowedReply;
+        if (kind != c.kind) {
+            if (c.owed > c.sent) {
+                c.stalled = true;
+                break;
+            }
+            c.kind = kind;
+            c.owed = c.sent = 0;
+        }
+        if (req.length > c.in_len - used) {
+            c.skip = req.length - (c.in_len - used);
+            used = c.in_len;
+        } else {
+            used += req.length;
+        }
+        c.owed += w.reply_len[kind];
+        note_request(w, c);
+        if (req.close)
+            c.close_after = true;
+    }
+    std::memmove(c.in, c.in + used, c.in_len - used);
+    c.in_len -= used;
+    return true;
+}
+
+// Reads and parses pipelined HTTP requests; returns false to drop the client.
+bool read_http(Worker &w, int fd, Conn &c) {
+    for (;;) {
+        if (c.close_after || c.stalled)
+            return true;
+        ssize_t n = ::read(fd, c.in + c.in_len, kInputBytes - c.in_len);
+        // Half-close: answer what was already asked, then close.
+        if (n == 0) {
+            c.close_after = true;
+            return true;
+        }
+        if (n < 0)
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        c.in_len += static_cast<std::size_t>(n);
+        if (!parse_buffered(w, c))
+            return false;
+        // A request head larger than the buffer.
+        if (!c.stalled && c.in_len == kInputBytes)
+            return false;
+    }
+}
+
+void drop(Worker &w, int fd) {
+    w.conns[static_cast<std::size_t>(fd)].active = false;
+    ::close(fd);
+}
+
+// Flushes owed replies and updates the epoll interest set; closes the
+// connection when it is finished.
+void settle(Worker &w, int fd, Conn &c, bool ok) {
+    ok = ok && flush_owed(w, fd, c);
+    while (ok && c.owed == 0 && c.stalled)
+        ok = parse_buffered(w, c) && flush_owed(w, fd, c);
+    bool done = c.owed == 0;
+    if (!ok || (done && c.close_after)) {
+        drop(w, fd);
+        return;
+    }
+    if (done == c.want_out) {
+        c.want_out = !done;
+        epoll_event ev = {};
+        ev.events = c.want_out ? EPOLLOUT : EPOLLIN;
+        ev.data.fd = fd;
+        ::epoll_ctl(w.ep, EPOLL_CTL_MOD, fd, &ev);
+    }
+}
+
+void on_accept(Worker &w) {
+    for (;;) {
+        int fd = ::accept4(w.listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+            return;
+        if (w.conns.size() <= static_cast<std::size_t>(fd))
+            w.conns.resize(static_cast<std::size_t>(fd) + 1);
+        Conn &c = w.conns[static_cast<std::size_t>(fd)];
+        c.active = true;
+        c.owed = c.sent = 0;
+        c.pending = 0;
+        c.skip = 0;
+        c.in_len = 0;
+        c.want_out = false;
+        c.stalled = false;
+        c.kind = kGetReply;
+        c.close_after = w.protocol == TcpProtocol::Greeting;
+        if (w.metrics)
+            w.metrics->add_connection();
+        if (c.close_after) {
+            c.owed = w.reply_len[kGetReply];
+            note_request(w, c);
+            if (!flush_owed(w, fd, c) || c.owed == 0) {
+                drop(w, fd);
+                continue;
+            }
+            c.want_out = true;
+        }
+        epoll_event ev = {};
+        ev.events = c.want_out ? EPOLLOUT : EPOLLIN;
+        ev.data.fd = fd;
+        ::epoll_ctl(w.ep, EPOLL_CTL_ADD, fd, &ev);
+    }
+}
+
+void run_worker(Worker &w, int &status) {
+    w.ep = ::epoll_create1(EPOLL_CLOEXEC);
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = w.listener;
+    if (w.ep < 0 || ::epoll_ctl(w.ep, EPOLL_CTL_ADD, w.listener, &ev) != 0) {
+        std::perror("epoll");
+        status = 1;
+        return;
+    }
+
+    epoll_event events[kMaxEvents];
+    while (!stop_requested()) {
+        int n = ::epoll_wait(w.ep, events, kMaxEvents, kStopPollMs);
+        if (n < 0 && errno != EINTR) {
+            std::perror("epoll_wait");
+            status = 1;
+            break;
+        }
+        if (w.metrics && n > 0)
+            w.woke_ns = monotonic_ns();
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == w.listener) {
+                on_accept(w);
+                continue;
+            }
+            Conn &c = w.conns[static_cast<std::size_t>(fd)];
+            bool ok = !(events[i].events & EPOLLERR);
+            if (ok && (events[i].events & (EPOLLIN | EPOLLHUP)) && w.protocol == TcpProtocol::Http)
+                ok = read_http(w, fd, c);
+            else if (ok && !(events[i].events & EPOLLOUT))
+                ok = false;
+            settle(w, fd, c, ok);
+        }
+        if (w.answered) {
+            w.metrics->observe(monotonic_ns() - w.woke_ns, w.answered);
+            w.answered = 0;
+        }
+    }
+    for (std::size_t fd = 0; fd < w.conns.size(); ++fd)
+        if (w.conns[fd].active)
+            ::close(static_cast<int>(fd));
+    ::close(w.ep);
+}
+
+int open_listener(std::uint16_t port, bool reuseport) {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+    int one = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if ((reuseport && ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) != 0) ||
+        ::bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+        ::listen(fd, SOMAXCONN) != 0) {
+        int saved = errno;
+        ::close(fd);
+        errno = saved;
+        return -1;
+    }
+    return fd;
+}
+
+} // namespace
+
+int listen_tcp_reuseport(std::uint16_t port) {
+    return open_listener(port, true);
+}
+
+int listen_tcp(std::uint16_t port) {
+    return open_listener(port, false);
+}
+
+int serve_tcp(const TcpServerConfig &config, std::string_view reply) {
+    if (reply.empty())
+        return 0;
+    unsigned threads = resolve_thread_count(config.threads);
+    std::vector<Worker> workers(threads);
+    Metrics metrics(threads);
+    for (unsigned i = 0; i < threads; ++i) {
+        Worker &w = workers[i];
+        w.listener = listen_tcp_reuseport(config.port);
+        if (w.listener < 0) {
+            std::fprintf(stderr, "127.0.0.1:%u: %s\n", config.port, std::strerror(errno));
+            for (unsigned j = 0; j < i; ++j)
+                ::close(workers[j].listener);
+            return 1;
+        }
+        w.protocol = config.protocol;
+        if (config.metrics_port)
+            w.metrics = &metrics.shard(i);
+        std::string_view replies[kReplyKinds] = {reply, reply, kNotAllowed};
+        std::size_t head = reply.find("\r\n\r\n");
+        if (head != std::string_view::npos)
+            replies[kHeadReply] = reply.substr(0, head + 4);
+        for (int kind = 0; kind < kReplyKinds; ++kind) {
+            std::string_view r = replies[kind];
+            w.reply_len[kind] = r.size();
+            w.block[kind].reserve(r.size() * kReplyCopies);
+            for (std::size_t k = 0; k < kReplyCopies; ++k)
+                w.block[kind] += r;
+        }
+    }
+    install_stop_handlers();
+    MetricsEndpoint endpoint;
+    std::string error;
+    if (config.metrics_port && !endpoint.start(config.metrics_port, metrics, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        for (Worker &w : workers)
+            ::close(w.listener);
+        return 1;
+    }
+
+    std::vector<int> status(threads, 0);
+    std::vector<std::thread> loops;
+    for (unsigned i = 0; i < threads; ++i) {
+        loops.emplace_back(run_worker, std::ref(workers[i]), std::ref(status[i]));
+        pin_to_cpu(loops.back(), i);
+    }
+    int rc = 0;
+    for (unsigned i = 0; i < threads; ++i) {
+        loops[i].join();
+        ::close(workers[i].listener);
+        rc |= status[i];
+    }
+    return rc;
+}
+
+} // namespace garda
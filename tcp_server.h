@@ -0,0 +1,43 @@
+#ifndef GARDA_TCP_SERVER_H
+#define GARDA_TCP_SERVER_H
+
+#include <cstdint>
+#include <string_view>
+
+namespace garda {
+
+enum class TcpProtocol {
+    // Send the reply to every new connection, then close it.
+    Greeting,
+    // Answer each HTTP/1.1 request with the reply, a complete response (see
+    // render_http_response()); supports keep-alive and pipelined requests.
+    Http,
+};
+
+struct TcpServerConfig {
+    std::uint16_t port = 0;
+    TcpProtocol protocol = TcpProtocol::Greeting;
+    // Number of event loops; 0 means one per CPU the process may run on.
+    unsigned threads = 0;
+    // Serve Prometheus metrics on 127.0.0.1:metrics_port; 0 disables them.
+    std::uint16_t metrics_port = 0;
+};
+
+// Serves reply on 127.0.0.1:port until SIGINT/SIGTERM. Each worker thread
+// owns an SO_REUSEPORT listener and an epoll loop, so the kernel shards
+// incoming connections across cores without a shared accept queue. Serving
+// a request only copies bytes from a per-worker block of replies. With
+// metrics enabled each worker also records into its own MetricsShard.
+// Returns a process exit code.
+int serve_tcp(const TcpServerConfig &config, std::string_view reply);
+
+// Opens a non-blocking SO_REUSEPORT listener on 127.0.0.1:port; -1 on error.
+int listen_tcp_reuseport(std::uint16_t port);
+
+// Same without SO_REUSEPORT, for a port only one socket may own: binding
+// fails if anything else listens there.
+int listen_tcp(std::uint16_t port);
+
+} // namespace garda
+
+#endif // GARDA_TCP_SERVER_H
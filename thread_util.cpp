@@ -0,0 +1,44 @@
+#include "thread_util.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+namespace garda {
+
+namespace {
+
+// CPUs this process may run on (taskset, cgroup cpusets); false if unknown.
+bool allowed_cpus(cpu_set_t &set) {
+    CPU_ZERO(&set);
+    return ::sched_getaffinity(0, sizeof(set), &set) == 0 && CPU_COUNT(&set) > 0;
+}
+
+} // namespace
+
+unsigned resolve_thread_count(unsigned requested) {
+    if (requested)
+        return requested;
+    cpu_set_t set;
+    if (allowed_cpus(set))
+        return static_cast<unsigned>(CPU_COUNT(&set));
+    unsigned n = std::thread::hardware_concurrency();
+    return n ? n : 1;
+}
+
+void pin_to_cpu(std::thread &t, unsigned index) {
+    cpu_set_t allowed;
+    if (!allowed_cpus(allowed))
+        return;
+    unsigned skip = index % static_cast<unsigned>(CPU_COUNT(&allowed));
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (!CPU_ISSET(cpu, &allowed) || skip-- > 0)
+            continue;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        ::pthread_setaffinity_np(t.native_handle(), sizeof(set), &set);
+        return;
+    }
+}
+
+} // namespace garda
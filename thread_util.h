@@ -0,0 +1,18 @@
+#ifndef GARDA_THREAD_UTIL_H
+#define GARDA_THREAD_UTIL_H
+
+#include <thread>
+
+namespace garda {
+
+// Maps a --threads value to a worker count; 0 means one per CPU the process
+// may run on.
+unsigned resolve_thread_count(unsigned requested);
+
+// Binds t to the index-th CPU, modulo their number, of those the process may
+// run on (its affinity mask); best effort.
+void pin_to_cpu(std::thread &t, unsigned index);
+
+} // namespace garda
+
+#endif // GARDA_THREAD_UTIL_H
@@ -0,0 +1,218 @@
+#include "unix_service.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "frame.h"
+#include "signals.h"
+#include "stats.h"
+
+namespace garda {
+
+namespace {
+
+constexpr std::size_t kReplyCopies = 64;
+
+struct Client {
+    int fd;
+    // Bytes of the endless reply stream that are owed and already sent.
+    std::uint64_t owed = 0;
+    std::uint64_t sent = 0;
+    // The client shut down its side; it is closed once everything owed
+    // has been sent.
+    bool read_closed = false;
+};
+
+bool fill_address(const std::string &path, sockaddr_un &addr) {
+    if (path.size() >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return false;
+    }
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+// Reads pending requests; returns false on error. End of input only marks
+// the client read-closed: replies to requests sent before a half-close
+// (shutdown(SHUT_WR)) are still owed.
+bool on_readable(Client &c, std::size_t frame_len) {
+    char buf[4096];
+    for (;;) {
+        ssize_t n = ::read(c.fd, buf, sizeof(buf));
+        if (n > 0) {
+            c.owed += static_cast<std::uint64_t>(n) * frame_len;
+            continue;
+        }
+        if (n == 0) {
+            c.read_closed = true;
+            return true;
+        }
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+}
+
+// Sends owed bytes from the pre-rendered block; returns false on error.
+bool on_writable(Client &c, const std::string &block, std::size_t frame_len) {
+    while (c.owed > c.sent) {
+        std::size_t off = static_cast<std::size_t>(c.sent % frame_len);
+        std::size_t len = block.size() - off;
+        if (c.owed - c.sent < len)
+            len = static_cast<std::size_t>(c.owed - c.sent);
+        ssize_t n = ::write(c.fd, block.data() + off, len);
+        if (n < 0)
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        note_write(static_cast<std::size_t>(n));
+        c.sent += static_cast<std::uint64_t>(n);
+    }
+    c.owed = c.sent = 0;
+    return true;
+}
+
+} // namespace
+
+int connect_unix(const std::string &path) {
+    sockaddr_un addr;
+    if (!fill_address(path, addr))
+        return -1;
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+    if (::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+        int saved = errno;
+        ::close(fd);
+        errno = saved;
+        return -1;
+    }
+    return fd;
+}
+
+int listen_unix(const std::string &path) {
+    sockaddr_un addr;
+    if (!fill_address(path, addr))
+        return -1;
+    int listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listener < 0)
+        return -1;
+    ::unlink(path.c_str());
+    if (::bind(listener, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listener, SOMAXCONN) != 0) {
+        int saved = errno;
+        ::close(listener);
+        errno = saved;
+        return -1;
+    }
+    return listener;
+}
+
+int serve_unix(const std::string &path, std::string_view frame) {
+    if (frame.size() < kFrameHeader) {
+        std::fprintf(stderr, "%s: reply is not framed\n", path.c_str());
+        return 1;
+    }
+    std::string block;
+    block.reserve(frame.size() * kReplyCopies);
+    for (std::size_t i = 0; i < kReplyCopies; ++i)
+        block += frame;
+
+    int listener = listen_unix(path);
+    if (listener < 0) {
+        std::fprintf(stderr, "%s: %s\n", path.c_str(), std::strerror(errno));
+        return 1;
+    }
+    install_stop_handlers();
+
+    std::vector<Client> clients;
+    std::vector<pollfd> fds;
+    while (!stop_requested()) {
+        fds.clear();
+        fds.push_back({listener, POLLIN, 0});
+        for (const Client &c : clients)
+            fds.push_back({c.fd, static_cast<short>(c.owed > c.sent ? POLLOUT : POLLIN), 0});
+        if (::poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            std::perror("poll");
+            break;
+        }
+
+        std::size_t live = 0;
+        for (std::size_t i = 0; i < clients.size(); ++i) {
+            Client &c = clients[i];
+            short ev = fds[i + 1].revents;
+            bool ok = true;
+            if (ev & POLLIN)
+                ok = on_readable(c, frame.size());
+            if (ok && (ev & (POLLOUT | POLLIN)))
+                ok = on_writable(c, block, frame.size());
+            if (ok && (ev & (POLLERR | POLLNVAL)))
+                ok = false;
+            if (ok && (ev & POLLHUP) && !(ev & POLLIN))
+                ok = false;
+            if (ok && c.read_closed && c.owed == c.sent)
+                ok = false;
+            if (ok)
+                clients[live++] = c;
+            else
+                ::close(c.fd);
+        }
+        clients.resize(live);
+
+        if (fds[0].revents & POLLIN) {
+            for (;;) {
+                int fd = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (fd < 0)
+                    break;
+                clients.push_back({fd});
+            }
+        }
+    }
+
+    for (const Client &c : clients)
+        ::close(c.fd);
+    ::close(listener);
+    ::unlink(path.c_str());
+    return 0;
+}
+
+bool request_unix(const std::string &path, std::string &reply, std::string &error) {
+    int fd = connect_unix(path);
+    if (fd < 0) {
+        error = path + ": " + std::strerror(errno);
+        return false;
+    }
+    errno = 0;
+    char header[kFrameHeader];
+    bool ok = ::write(fd, "g", 1) == 1;
+    std::size_t got = 0;
+    while (ok && got < sizeof(header)) {
+        ssize_t n = ::read(fd, header + got, sizeof(header) - got);
+        ok = n > 0;
+        got += ok ? static_cast<std::size_t>(n) : 0;
+    }
+    if (ok) {
+        reply.resize(decode_frame_length(header));
+        got = 0;
+        while (ok && got < reply.size()) {
+            ssize_t n = ::read(fd, &reply[got], reply.size() - got);
+            ok = n > 0;
+            got += ok ? static_cast<std::size_t>(n) : 0;
+        }
+    }
+    if (!ok)
+        error = path + ": " + (errno ? std::strerror(errno) : "connection closed");
+    ::close(fd);
+    return ok;
+}
+
+} // namespace garda
@@ -0,0 +1,27 @@
+#ifndef GARDA_UNIX_SERVICE_H
+#define GARDA_UNIX_SERVICE_H
+
+#include <string>
+#include <string_view>
+
+namespace garda {
+
+// Serves over a Unix stream socket at path until SIGINT/SIGTERM. Every byte
+// a client sends is one request and is answered with one copy of frame, an
+// already length-prefixed reply (see frame.h and message.h). Returns a
+// process exit code.
+int serve_unix(const std::string &path, std::string_view frame);
+
+// Sends one request to the server at path and stores the payload in reply.
+bool request_unix(const std::string &path, std::string &reply, std::string &error);
+
+// Connects to path; returns the socket or -1 with errno set.
+int connect_unix(const std::string &path);
+
+// Binds a non-blocking listening socket at path, replacing a stale socket
+// file; returns it or -1 with errno set.
+int listen_unix(const std::string &path);
+
+} // namespace garda
+
+#endif // GARDA_UNIX_SERVICE_H
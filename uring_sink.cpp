@@ -0,0 +1,324 @@
+#include "uring_sink.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "stats.h"
+
+namespace garda {
+
+namespace {
+
+int sys_io_uring_setup(unsigned entries, io_uring_params *p) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, p));
+}
+
+int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(
+        ::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int sys_io_uring_register(int fd, unsigned opcode, const void *arg, unsigned nr_args) {
+    return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+template <typename T>
+T *at(void *base, unsigned offset) {
+    return reinterpret_cast<T *>(static_cast<char *>(base) + offset);
+}
+
+// Regular files not opened with O_APPEND accept explicit offsets, so their
+// writes may complete in any order.
+bool is_positioned(int fd, std::uint64_t &offset) {
+    struct stat st;
+    int flags = ::fcntl(fd, F_GETFL);
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || flags < 0 || (flags & O_APPEND))
+        return false;
+    off_t pos = ::lseek(fd, 0, SEEK_CUR);
+    if (pos < 0)
+        return false;
+    offset = static_cast<std::uint64_t>(pos);
+    return true;
+}
+
+} // namespace
+
+UringSink::UringSink(int fd, const UringConfig &config) : fd_(fd) {
+    if (!setup(config))
+        teardown();
+}
+
+UringSink::~UringSink() {
+    sync();
+    teardown();
+}
+
+bool UringSink::setup(const UringConfig &config) {
+    unsigned depth = std::max(1u, config.queue_depth);
+    slot_bytes_ = std::max<std::size_t>(4096, config.buffer_bytes);
+    stream_ = !is_positioned(fd_, offset_);
+
+    io_uring_params p;
+    std::memset(&p, 0, sizeof(p));
+    ring_fd_ = sys_io_uring_setup(depth, &p);
+    if (ring_fd_ < 0)
+        return false;
+
+    sq_ring_len_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cq_ring_len_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+    if (single)
+        sq_ring_len_ = cq_ring_len_ = std::max(sq_ring_len_, cq_ring_len_);
+    sq_ring_ = ::mmap(nullptr, sq_ring_len_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+        sq_ring_ = nullptr;
+        return false;
+    }
+    if (single) {
+        cq_ring_ = sq_ring_;
+    } else {
+        cq_ring_ = ::mmap(nullptr, cq_ring_len_, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+        if (cq_ring_ == MAP_FAILED) {
+            cq_ring_ = nullptr;
+            return false;
+        }
+    }
+    sqes_len_ = p.sq_entries * sizeof(io_uring_sqe);
+    void *sqes = ::mmap(nullptr, sqes_len_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ring_fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+        return false;
+    sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+    sq_tail_ = at<unsigned>(sq_ring_, p.sq_off.tail);
+    sq_mask_ = at<unsigned>(sq_ring_, p.sq_off.ring_mask);
+    sq_array_ = at<unsigned>(sq_ring_, p.sq_off.array);
+    cq_head_ = at<unsigned>(cq_ring_, p.cq_off.head);
+    cq_tail_ = at<unsigned>(cq_ring_, p.cq_off.tail);
+    cq_mask_ = at<unsigned>(cq_ring_, p.cq_off.ring_mask);
+    cqes_ = at<io_uring_cqe>(cq_ring_, p.cq_off.cqes);
+
+    buffers_len_ = slot_bytes_ * depth;
+    void *buffers = ::mmap(nullptr, buffers_len_, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (buffers == MAP_FAILED)
+        return false;
+    buffers_ = static_cast<char *>(buffers);
+    std::vector<iovec> iov(depth);
+    for (unsigned i = 0; i < depth; ++i)
+        iov[i] = {buffers_ + i * slot_bytes_, slot_bytes_};
+    if (sys_io_uring_register(ring_fd_, IORING_REGISTER_BUFFERS, iov.data(), depth) != 0)
+        return false;
+    slots_.assign(depth, Slot());
+    order_.reserve(depth);
+    return true;
+}
+
+void UringSink::teardown() {
+    if (buffers_)
+        ::munmap(buffers_, buffers_len_);
+    if (sqes_)
+        ::munmap(sqes_, sqes_len_);
+    if (cq_ring_ && cq_ring_ != sq_ring_)
+        ::munmap(cq_ring_, cq_ring_len_);
+    if (sq_ring_)
+        ::munmap(sq_ring_, sq_ring_len_);
+    if (ring_fd_ >= 0)
+        ::close(ring_fd_);
+    buffers_ = nullptr;
+    sqes_ = nullptr;
+    cq_ring_ = sq_ring_ = nullptr;
+    ring_fd_ = -1;
+    slots_.clear();
+}
+
+bool UringSink::write_sync(const char *data, std::size_t n, std::uint64_t offset,
+                           bool positioned) {
+    while (n > 0) {
+        ++writes_;
+        ssize_t w = positioned ? ::pwrite(fd_, data, n, static_cast<off_t>(offset))
+                               : ::write(fd_, data, n);
+        if (w < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        note_write(static_cast<std::size_t>(w));
+        data += w;
+        n -= static_cast<std::size_t>(w);
+        offset += static_cast<std::uint64_t>(w);
+    }
+    return true;
+}
+
+bool UringSink::write(const char *data, std::size_t n) {
+    if (!uses_uring()) {
+        ok_ = write_sync(data, n, 0, false) && ok_;
+        return ok_;
+    }
+    while (n > 0 && ok_) {
+        int s = free_slot();
+        if (s < 0)
+            break;
+        std::size_t chunk = std::min(n, slot_bytes_);
+        char *buf = buffers_ + static_cast<std::size_t>(s) * slot_bytes_;
+        std::memcpy(buf, data, chunk);
+
+        Slot &slot = slots_[static_cast<std::size_t>(s)];
+        slot = {chunk, offset_, seq_++, 0, true};
+        unsigned tail = *sq_tail_;
+        unsigned index = tail & *sq_mask_;
+        io_uring_sqe &sqe = sqes_[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_WRITE_FIXED;
+        sqe.fd = fd_;
+        sqe.addr = reinterpret_cast<std::uint64_t>(buf);
+        sqe.len = static_cast<std::uint32_t>(chunk);
+        sqe.off = stream_ ? ~std::uint64_t(0) : offset_;
+        sqe.buf_index = static_cast<std::uint16_t>(s);
+        sqe.user_data = static_cast<std::uint64_t>(s);
+        sq_array_[index] = index;
+        __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+        ++queued_;
+        ++submissions_;
+
+        offset_ += chunk;
+        data += chunk;
+        n -= chunk;
+    }
+    return ok_;
+}
+
+int UringSink::free_slot() {
+    for (;;) {
+        for (std::size_t i = 0; i < slots_.size(); ++i)
+            if (!slots_[i].busy)
+                return static_cast<int>(i);
+        if (stream_) {
+            if (!finish_chain())
+                return -1;
+            continue;
+        }
+        // Submit what is queued and wait for half of the ring, so the
+        // device keeps working while the freed buffers are refilled.
+        unsigned busy = queued_ + in_flight_;
+        if (!enter(queued_, std::max(1u, busy / 2)) || !reap())
+            return -1;
+    }
+}
+
+bool UringSink::enter(unsigned to_submit, unsigned min_complete) {
+    for (;;) {
+        int r = sys_io_uring_enter(ring_fd_, to_submit, min_complete,
+                                   min_complete ? IORING_ENTER_GETEVENTS : 0);
+        ++writes_;
+        if (r < 0) {
+            if (errno == EINTR)
+                continue;
+            ok_ = false;
+            return false;
+        }
+        // Bytes are counted as their completions are reaped.
+        note_write(0);
+        unsigned submitted = static_cast<unsigned>(r);
+        queued_ -= submitted;
+        in_flight_ += submitted;
+        to_submit -= submitted;
+        if (to_submit == 0)
+            return true;
+    }
+}
+
+bool UringSink::reap() {
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head) {
+        const io_uring_cqe &cqe = cqes_[head & *cq_mask_];
+        Slot &slot = slots_[static_cast<std::size_t>(cqe.user_data)];
+        slot.res = cqe.res;
+        if (slot.res > 0)
+            note_bytes(static_cast<std::size_t>(slot.res));
+        --in_flight_;
+        if (stream_)
+            continue;
+        // Positioned writes are independent; finish a short one in place.
+        if (slot.res < 0) {
+            ok_ = false;
+        } else if (static_cast<std::size_t>(slot.res) < slot.len) {
+            const char *buf = buffers_ + cqe.user_data * slot_bytes_;
+            std::size_t done = static_cast<std::size_t>(slot.res);
+            ok_ = write_sync(buf + done, slot.len - done, slot.offset + done, true) && ok_;
+        }
+        slot.busy = false;
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    return ok_;
+}
+
+// Submits the queued writes as one linked chain, waits for all of them and
+// then repairs, in submission order, anything the chain did not write.
+bool UringSink::finish_chain() {
+    if (queued_) {
+        unsigned tail = *sq_tail_;
+        for (unsigned i = queued_; i > 1; --i)
+            sqes_[(tail - i) & *sq_mask_].flags |= IOSQE_IO_LINK;
+        if (!enter(queued_, queued_ + in_flight_))
+            return false;
+    }
+    reap();
+    while (in_flight_) {
+        if (!enter(0, in_flight_))
+            return false;
+        reap();
+    }
+
+    order_.clear();
+    for (std::size_t i = 0; i < slots_.size(); ++i)
+        if (slots_[i].busy)
+            order_.push_back(i);
+    std::sort(order_.begin(), order_.end(),
+              [&](std::size_t a, std::size_t b) { return slots_[a].seq < slots_[b].seq; });
+    for (std::size_t i : order_) {
+        Slot &slot = slots_[i];
+        const char *buf = buffers_ + i * slot_bytes_;
+        if (slot.res == -ECANCELED)
+            slot.res = 0;
+        if (slot.res < 0)
+            ok_ = false;
+        else if (ok_ && static_cast<std::size_t>(slot.res) < slot.len)
+            ok_ = write_sync(buf + slot.res, slot.len - static_cast<std::size_t>(slot.res), 0,
+                             false);
+        slot.busy = false;
+    }
+    return ok_;
+}
+
+bool UringSink::sync() {
+    if (!uses_uring())
+        return ok_;
+    if (stream_)
+        return finish_chain();
+    if (queued_ && !enter(queued_, 0))
+        return false;
+    reap();
+    while (in_flight_) {
+        if (!enter(0, in_flight_))
+            return false;
+        reap();
+    }
+    ::lseek(fd_, static_cast<off_t>(offset_), SEEK_SET);
+    return ok_;
+}
+
+} // namespace garda
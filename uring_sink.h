@@ -0,0 +1,97 @@
+#ifndef GARDA_URING_SINK_H
+#define GARDA_URING_SINK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "output.h"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace garda {
+
+struct UringConfig {
+    // Number of registered buffers, i.e. writes that can be in flight.
+    unsigned queue_depth = 8;
+    // Size of each registered buffer; larger writes are split.
+    std::size_t buffer_bytes = 256 * 1024;
+};
+
+// Sink that submits writes through io_uring using IORING_OP_WRITE_FIXED on
+// pre-registered buffers. write() copies into a free buffer and queues an
+// SQE; io_uring_enter() runs only when every buffer is busy or on sync(),
+// so one syscall submits and reaps a whole batch.
+//
+// Regular files get explicit offsets and complete in any order. Pipes,
+// sockets and O_APPEND files get each batch as one IOSQE_IO_LINK chain, so
+// bytes keep their order. Short or cancelled chain members are finished
+// with plain write(2). If io_uring is unavailable the sink quietly does
+// plain write(2) instead (see uses_uring()).
+class UringSink : public Sink {
+public:
+    explicit UringSink(int fd, const UringConfig &config = UringConfig());
+    ~UringSink() override;
+
+    UringSink(const UringSink &) = delete;
+    UringSink &operator=(const UringSink &) = delete;
+
+    bool write(const char *data, std::size_t n) override;
+    bool sync() override;
+
+    bool uses_uring() const { return ring_fd_ >= 0; }
+    // SQEs queued so far; writes() counts io_uring_enter() calls.
+    std::uint64_t submissions() const { return submissions_; }
+
+private:
+    struct Slot {
+        std::size_t len = 0;
+        std::uint64_t offset = 0;
+        std::uint64_t seq = 0;
+        int res = 0;
+        bool busy = false;
+    };
+
+    bool setup(const UringConfig &config);
+    void teardown();
+    bool write_sync(const char *data, std::size_t n, std::uint64_t offset, bool positioned);
+    int free_slot();
+    bool enter(unsigned to_submit, unsigned min_complete);
+    bool reap();
+    bool finish_chain();
+
+    int fd_;
+    int ring_fd_ = -1;
+    bool stream_ = true;
+    bool ok_ = true;
+    std::uint64_t offset_ = 0;
+    std::uint64_t seq_ = 0;
+    std::uint64_t submissions_ = 0;
+    unsigned queued_ = 0;
+    unsigned in_flight_ = 0;
+
+    std::size_t slot_bytes_ = 0;
+    char *buffers_ = nullptr;
+    std::size_t buffers_len_ = 0;
+    std::vector<Slot> slots_;
+    std::vector<std::size_t> order_;
+
+    void *sq_ring_ = nullptr;
+    void *cq_ring_ = nullptr;
+    std::size_t sq_ring_len_ = 0;
+    std::size_t cq_ring_len_ = 0;
+    io_uring_sqe *sqes_ = nullptr;
+    std::size_t sqes_len_ = 0;
+    io_uring_cqe *cqes_ = nullptr;
+    unsigned *sq_tail_ = nullptr;
+    unsigned *sq_mask_ = nullptr;
+    unsigned *sq_array_ = nullptr;
+    unsigned *cq_head_ = nullptr;
+    unsigned *cq_tail_ = nullptr;
+    unsigned *cq_mask_ = nullptr;
+};
+
+} // namespace garda
+
+#endif // GARDA_URING_SINK_H
@@ -0,0 +1,220 @@
+#include "zygote.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "signals.h"
+#include "unix_service.h"
+
+namespace garda {
+
+namespace {
+
+struct Reply {
+    std::int32_t pid;
+    std::int32_t status;
+};
+
+struct Client {
+    int fd;
+    // Running child and its pidfd, or -1 while waiting for a request.
+    pid_t pid = -1;
+    int pidfd = -1;
+};
+
+// Reads one request: the count and the attached descriptor. Returns false
+// if the client is gone or broke the protocol; out_fd is -1 if nothing
+// complete arrived yet.
+bool read_request(int fd, std::uint64_t &count, int &out_fd) {
+    out_fd = -1;
+    char control[CMSG_SPACE(sizeof(int))];
+    iovec iov = {&count, sizeof(count)};
+    msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    ssize_t n = ::recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+    if (n < 0)
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    for (cmsghdr *c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c)) {
+        if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_RIGHTS)
+            std::memcpy(&out_fd, CMSG_DATA(c), sizeof(int));
+    }
+    if (n == static_cast<ssize_t>(sizeof(count)) && out_fd >= 0)
+        return true;
+    if (out_fd >= 0)
+        ::close(out_fd);
+    out_fd = -1;
+    return false;
+}
+
+// Child side of fork(): leave the server's descriptors and signal setup
+// behind, then run the job. clients may hold numbers of descriptors that
+// were closed this round; out_fd is the only one opened since.
+[[noreturn]] void run_child(const ZygoteJob &job, int listener,
+                            const std::vector<Client> &clients, int out_fd,
+                            std::uint64_t count) {
+    ::close(listener);
+    for (const Client &c : clients) {
+        if (c.fd != out_fd)
+            ::close(c.fd);
+        if (c.pidfd >= 0 && c.pidfd != out_fd)
+            ::close(c.pidfd);
+    }
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+    std::signal(SIGPIPE, SIG_DFL);
+    int code = job(out_fd, count);
+    ::_exit(code);
+}
+
+// pid 0 tells the client that fork() failed.
+void send_reply(int fd, pid_t pid, int status) {
+    Reply r = {static_cast<std::int32_t>(pid), status};
+    // The socket buffer is empty between requests, so this never blocks.
+    if (::send(fd, &r, sizeof(r), MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof(r)))
+        ::shutdown(fd, SHUT_RDWR);
+}
+
+} // namespace
+
+int serve_zygote(const std::string &path, const ZygoteJob &job) {
+    int listener = listen_unix(path);
+    if (listener < 0) {
+        std::fprintf(stderr, "%s: %s\n", path.c_str(), std::strerror(errno));
+        return 1;
+    }
+    install_stop_handlers();
+
+    std::vector<Client> clients;
+    std::vector<pollfd> fds;
+    while (!stop_requested()) {
+        fds.clear();
+        fds.push_back({listener, POLLIN, 0});
+        for (const Client &c : clients)
+            fds.push_back(c.pid < 0 ? pollfd{c.fd, POLLIN, 0} : pollfd{c.pidfd, POLLIN, 0});
+        if (::poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            std::perror("poll");
+            break;
+        }
+
+        std::size_t live = 0;
+        for (std::size_t i = 0; i < clients.size(); ++i) {
+            Client c = clients[i];
+            short ev = fds[i + 1].revents;
+            bool ok = true;
+            if (c.pid >= 0 && ev) {
+                int status = 0;
+                ::waitpid(c.pid, &status, 0);
+                send_reply(c.fd, c.pid, status);
+                ::close(c.pidfd);
+                c.pid = c.pidfd = -1;
+            } else if (c.pid < 0 && ev) {
+                std::uint64_t count = 0;
+                int out_fd = -1;
+                ok = read_request(c.fd, count, out_fd) && !(ev & (POLLERR | POLLNVAL));
+                if (ok && out_fd >= 0) {
+                    pid_t pid = ::fork();
+                    if (pid == 0)
+                        run_child(job, listener, clients, out_fd, count);
+                    ::close(out_fd);
+                    if (pid < 0) {
+                        std::perror("fork");
+                        send_reply(c.fd, 0, 0);
+                    } else {
+                        c.pid = pid;
+                        c.pidfd = static_cast<int>(::syscall(SYS_pidfd_open, pid, 0));
+                        if (c.pidfd < 0) {
+                            // No pidfds (Linux < 5.3): wait for this child now.
+                            int status = 0;
+                            ::waitpid(pid, &status, 0);
+                            send_reply(c.fd, pid, status);
+                            c.pid = -1;
+                        }
+                    }
+                } else if (ok && (ev & POLLHUP)) {
+                    ok = false;
+                }
+            }
+            if (ok)
+                clients[live++] = c;
+            else
+                ::close(c.fd);
+        }
+        clients.resize(live);
+
+        if (fds[0].revents & POLLIN) {
+            for (;;) {
+                int fd = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (fd < 0)
+                    break;
+                clients.push_back({fd});
+            }
+        }
+    }
+
+    for (const Client &c : clients) {
+        if (c.pid > 0) {
+            ::waitpid(c.pid, nullptr, 0);
+            ::close(c.pidfd);
+        }
+        ::close(c.fd);
+    }
+    ::close(listener);
+    ::unlink(path.c_str());
+    return 0;
+}
+
+bool zygote_spawn(int conn, int out_fd, std::uint64_t count, int &pid, int &status,
+                  std::string &error) {
+    char control[CMSG_SPACE(sizeof(int))] = {};
+    iovec iov = {&count, sizeof(count)};
+    msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    cmsghdr *c = CMSG_FIRSTHDR(&msg);
+    c->cmsg_level = SOL_SOCKET;
+    c->cmsg_type = SCM_RIGHTS;
+    c->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(c), &out_fd, sizeof(int));
+    if (::sendmsg(conn, &msg, MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof(count))) {
+        error = std::string("zygote request: ") + std::strerror(errno);
+        return false;
+    }
+    Reply r;
+    std::size_t got = 0;
+    while (got < sizeof(r)) {
+        ssize_t n = ::read(conn, reinterpret_cast<char *>(&r) + got, sizeof(r) - got);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR)
+                continue;
+            error = std::string("zygote reply: ") +
+                    (n < 0 ? std::strerror(errno) : "connection closed");
+            return false;
+        }
+        got += static_cast<std::size_t>(n);
+    }
+    if (r.pid <= 0) {
+        error = "zygote could not fork";
+        return false;
+    }
+    pid = r.pid;
+    status = r.status;
+    return true;
+}
+
+} // namespace garda
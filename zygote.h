@@ -0,0 +1,37 @@
+#ifndef GARDA_ZYGOTE_H
+#define GARDA_ZYGOTE_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace garda {
+
+// Work done by one forked child: write count greetings to out_fd and
+// return the child's exit code.
+using ZygoteJob = std::function<int(int out_fd, std::uint64_t count)>;
+
+// Fork server. The calling process has already done its start-up work
+// (options, catalog lookup, pre-rendered replies); it listens on a Unix
+// socket at path and, for every request, forks a child that inherits that
+// state copy-on-write, runs job and exits. Clients get process isolation
+// per greeting without paying exec, dynamic linking and static
+// initialization each time.
+//
+// Protocol, per request on a connection (several may follow each other):
+// the client sends the count as 8 bytes in host order with the output
+// file descriptor attached (SCM_RIGHTS); once the child has exited the
+// server answers with its pid and wait status, two int32s. Children run
+// concurrently; exits are picked up through pidfds. Runs until
+// SIGINT/SIGTERM, then waits for running children. Returns a process exit
+// code.
+int serve_zygote(const std::string &path, const ZygoteJob &job);
+
+// Client side over an open connection to serve_zygote(): runs one job
+// writing to out_fd and stores the child's pid and wait status.
+bool zygote_spawn(int conn, int out_fd, std::uint64_t count, int &pid, int &status,
+                  std::string &error);
+
+} // namespace garda
+
+#endif // GARDA_ZYGOTE_H